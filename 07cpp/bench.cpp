@@ -0,0 +1,866 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono> /* std::chrono::steady_clock */
+#include <string>
+#include <vector>
+#include <algorithm> /* std::sort(), std::min() */
+#include <new> /* std::bad_alloc */
+#include <cmath> /* std::ceil() */
+#ifdef __linux__
+#include <sched.h> /* sched_setaffinity(), sched_getcpu() */
+#include <linux/perf_event.h> /* struct perf_event_attr */
+#include <sys/syscall.h> /* SYS_perf_event_open */
+#include <sys/ioctl.h> /* ioctl() */
+#include <unistd.h> /* syscall(), read(), close() */
+#include <cerrno> /* errno */
+#elif defined(_WIN32)
+#define NOMINMAX /* keep std::min() and std::max() */
+#include <windows.h> /* SetThreadAffinityMask(), GetCurrentProcessorNumber() */
+#endif
+#include "leptjson.h"
+#include "generator.h"
+
+/* bytes of the documents holding strings only and numbers only */
+#define BENCH_KERNEL_SIZE (1 << 20)
+/* distinct documents the latency mode cycles through */
+#define BENCH_LATENCY_POOL 4096
+/* request bodies of the latency mode are between these sizes */
+#define BENCH_LATENCY_MIN_SIZE 200
+#define BENCH_LATENCY_MAX_SIZE 4096
+
+static long long nanosNow(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef LEPT_ALLOC_STATS
+/* allocations so far, the library replaces operator new and counts them by phase */
+static size_t countAllocs(size_t& bytes)
+{
+    const Lept::AllocPhase phases[] = { Lept::AllocPhase::OTHER, Lept::AllocPhase::PARSE, Lept::AllocPhase::STRINGIFY, Lept::AllocPhase::DESTROY };
+    size_t count = 0;
+    bytes = 0;
+    for (Lept::AllocPhase phase : phases)
+    {
+        Lept::AllocStats stats = Lept::getAllocStats(phase);
+        count += stats.allocs;
+        bytes += stats.bytes;
+    }
+
+    return count;
+}
+#define BENCH_ALLOC_TIMING 0 /* the library owns operator new */
+#else
+#define BENCH_ALLOC_TIMING 1
+/* allocation counters, fed by the global operator new below */
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+/* nanoseconds inside malloc() and free(), counted while allocTiming is on */
+static bool allocTiming = false;
+static long long allocNanos = 0;
+static size_t allocCalls = 0;
+
+void* operator new(size_t size)
+{
+    ++allocCount;
+    allocBytes += size;
+    long long t0 = allocTiming ? nanosNow() : 0;
+    void* p = malloc(size != 0 ? size : 1);
+    if (allocTiming)
+    {
+        allocNanos += nanosNow() - t0;
+        ++allocCalls;
+    }
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+void operator delete(void* p) noexcept
+{
+    if (!allocTiming)
+    {
+        free(p);
+        return;
+    }
+    long long t0 = nanosNow();
+    free(p);
+    allocNanos += nanosNow() - t0;
+    ++allocCalls;
+}
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+/* allocations so far */
+static size_t countAllocs(size_t& bytes)
+{
+    bytes = allocBytes;
+
+    return allocCount;
+}
+#endif
+
+
+/* -------- hardware counters -------- */
+#if 1
+enum { COUNTER_CYCLES, COUNTER_INSTRUCTIONS, COUNTER_BRANCH_MISSES, COUNTER_L1D_MISSES, COUNTER_LLC_MISSES, COUNTER_EVENTS };
+static const char* const counterColumns[COUNTER_EVENTS] = { "cyc/B", "ins/B", "brmiss/B", "L1dmiss/B", "LLCmiss/B" };
+static const char* const counterMetrics[COUNTER_EVENTS] = { "cyclesPerByte", "instructionsPerByte", "branchMissesPerByte", "l1dMissesPerByte", "llcMissesPerByte" };
+
+/* user-space cycles, instructions, branch misses and L1d/LLC read misses of this thread through perf_event_open(), 
+ * each event on its own so that the ones a CPU, VM or perf_event_paranoid refuses are left out alone */
+class HardwareCounters
+{
+private:
+    int m_fds[COUNTER_EVENTS]; /* -1 where the event could not be opened */
+    /* time enabled and running at start(), which a reset leaves as they are */
+    uint64_t m_enabled[COUNTER_EVENTS];
+    uint64_t m_running[COUNTER_EVENTS];
+    int m_error; /* errno of the first refusal, 0 if none */
+
+public:
+    // Constructor; 
+    HardwareCounters(bool enabled);
+    // Destructor; 
+    ~HardwareCounters(void);
+
+    // get-Functions; 
+    bool isOpen(int event) const;
+    bool isAnyOpen(void) const;
+    int getError(void) const;
+
+    /* from zero */
+    void start(void);
+    /* counts since start(), scaled up where the kernel multiplexed the event, -1 where it is not open */
+    void stop(double* counts);
+};
+
+HardwareCounters::HardwareCounters(bool enabled) :
+    m_error(0)
+{
+    for (int event = 0; event < COUNTER_EVENTS; ++event)
+    {
+        this->m_fds[event] = -1;
+        this->m_enabled[event] = this->m_running[event] = 0;
+    }
+#ifdef __linux__
+    static const uint32_t types[COUNTER_EVENTS] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE };
+    static const uint64_t configs[COUNTER_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+    };
+    for (int event = 0; enabled && event < COUNTER_EVENTS; ++event)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[event];
+        attr.config = configs[event];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1; /* allowed up to perf_event_paranoid 2 */
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        this->m_fds[event] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (this->m_fds[event] < 0 && this->m_error == 0)
+            this->m_error = errno;
+    }
+#else
+    (void)enabled;
+    this->m_error = ENOSYS;
+#endif
+}
+HardwareCounters::~HardwareCounters(void)
+{
+#ifdef __linux__
+    for (int fd : this->m_fds)
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+}
+
+bool HardwareCounters::isOpen(int event) const
+{
+    return this->m_fds[event] >= 0;
+}
+bool HardwareCounters::isAnyOpen(void) const
+{
+    bool open = false;
+    for (int event = 0; event < COUNTER_EVENTS; ++event)
+        open = open || this->isOpen(event);
+
+    return open;
+}
+int HardwareCounters::getError(void) const
+{
+    return this->m_error;
+}
+
+void HardwareCounters::start(void)
+{
+#ifdef __linux__
+    for (int event = 0; event < COUNTER_EVENTS; ++event)
+    {
+        int fd = this->m_fds[event];
+        uint64_t values[3]; /* count, time enabled, time running */
+        if (fd < 0)
+            continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        if (read(fd, values, sizeof(values)) != (ssize_t)sizeof(values))
+            values[1] = values[2] = 0;
+        this->m_enabled[event] = values[1];
+        this->m_running[event] = values[2];
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    return;
+}
+void HardwareCounters::stop(double* counts)
+{
+    for (int event = 0; event < COUNTER_EVENTS; ++event)
+    {
+        counts[event] = -1.0;
+#ifdef __linux__
+        int fd = this->m_fds[event];
+        uint64_t values[3]; /* count, time enabled, time running */
+        if (fd < 0)
+            continue;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, values, sizeof(values)) != (ssize_t)sizeof(values))
+            continue;
+        /* the times add up over every region since the event was opened */
+        uint64_t enabled = values[1] - this->m_enabled[event], running = values[2] - this->m_running[event];
+        if (running != 0)
+            counts[event] = (double)values[0] * enabled / running;
+#endif
+    }
+
+    return;
+}
+#endif
+
+
+/* -------- measurement -------- */
+#if 1
+typedef struct
+{
+    std::string name;
+    std::string text;
+    size_t nodes; /* values, members' values included */
+} Document;
+
+typedef struct
+{
+    double best; /* seconds per run */
+    double median;
+    double allocs; /* per run */
+    double allocBytes;
+    double counts[COUNTER_EVENTS]; /* per run, -1 where the counter is not open */
+} Result;
+
+static size_t countNodes(const Lept::Value& v)
+{
+    size_t nodes = 1;
+    if (v.getType() == Lept::Type::ARRAY)
+    {
+        for (const Lept::Value* elem : *v.getArr())
+            nodes += countNodes(*elem);
+    }
+    else if (v.getType() == Lept::Type::OBJECT)
+    {
+        for (const Lept::Member* member : *v.getObj())
+            nodes += countNodes(*member->value);
+    }
+
+    return nodes;
+}
+
+/* run op warmup times, then iterations times measuring each run */
+template <typename Operation>
+static Result measure(HardwareCounters& counters, unsigned int warmup, unsigned int iterations, Operation op)
+{
+    for (unsigned int index = 0; index < warmup; ++index)
+        op();
+
+    Result r;
+    std::vector<double> times;
+    times.reserve(iterations);
+    size_t bytes, count = countAllocs(bytes);
+    counters.start();
+    for (unsigned int index = 0; index < iterations; ++index)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        op();
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    counters.stop(r.counts);
+    std::sort(times.begin(), times.end());
+
+    for (double& events : r.counts)
+        events = (events < 0.0) ? events : events / iterations;
+    r.best = times.front();
+    r.median = times[times.size() / 2];
+    size_t bytesAfter, countAfter = countAllocs(bytesAfter);
+    r.allocs = (double)(countAfter - count) / iterations;
+    r.allocBytes = (double)(bytesAfter - bytes) / iterations;
+    return r;
+}
+
+/* -------- result file -------- */
+#if 1
+/* results of a run as leptjson_bench -o writes them, the input of bench-compare: 
+ * { "tool": "leptjson_bench", "iterations": N, "warmup": N, 
+ *   "results": [ { "document": "twitter", "operation": "parse", "metrics": { "mbps": 81.2, ... } }, ... ] } 
+ * metrics named *Mbps are better higher, all others better lower */
+static Lept::Value* newNumber(double num)
+{
+    Lept::Value* v = new Lept::Value(Lept::Type::NUMBER);
+    v->setNum(num);
+
+    return v;
+}
+
+static Lept::Value* newString(const std::string& str)
+{
+    Lept::Value* v = new Lept::Value(Lept::Type::STRING);
+    v->setStr(str);
+
+    return v;
+}
+
+/* obj takes value over */
+static void addMember(Lept::Value& obj, const char* key, Lept::Value* value)
+{
+    Lept::Member* member = new Lept::Member;
+    member->key = new std::string(key);
+    member->value = value;
+    obj.appendObjElem(*member);
+
+    return;
+}
+
+/* appends a result to results, metrics are added to what this returns */
+static Lept::Value& addResult(Lept::Value& results, const std::string& document, const char* operation)
+{
+    Lept::Value* result = new Lept::Value(Lept::Type::OBJECT);
+    Lept::Value* metrics = new Lept::Value(Lept::Type::OBJECT);
+    addMember(*result, "document", newString(document));
+    addMember(*result, "operation", newString(operation));
+    addMember(*result, "metrics", metrics);
+    results.appendArrElem(*result);
+
+    return *metrics;
+}
+
+static bool writeResults(const char* path, Lept::Value& results, unsigned int iterations, unsigned int warmup)
+{
+    Lept::Value root(Lept::Type::OBJECT);
+    addMember(root, "tool", newString("leptjson_bench"));
+    addMember(root, "iterations", newNumber(iterations));
+    addMember(root, "warmup", newNumber(warmup));
+    Lept::Value* moved = new Lept::Value(Lept::Type::ARRAY);
+    moved->getArr()->swap(*results.getArr());
+    addMember(root, "results", moved);
+
+    return root.stringifyFile(path, Lept::Format()) == Lept::STRINGIFY_OK;
+}
+#endif
+
+static void report(const Document& doc, const char* op, Lept::Value& results, const HardwareCounters& counters, const Result& r)
+{
+    double mbps = doc.text.size() / 1e6 / r.median, bestMbps = doc.text.size() / 1e6 / r.best, nsPerNode = r.median * 1e9 / doc.nodes;
+    printf("%-10s %-17s %9.1f %9.1f %9.2f %12.0f %12.0f", doc.name.c_str(), op,
+        mbps, bestMbps, nsPerNode, r.allocs, r.allocBytes);
+
+    Lept::Value& metrics = addResult(results, doc.name, op);
+    addMember(metrics, "mbps", newNumber(mbps));
+    addMember(metrics, "bestMbps", newNumber(bestMbps));
+    addMember(metrics, "nsPerNode", newNumber(nsPerNode));
+    addMember(metrics, "allocs", newNumber(r.allocs));
+    addMember(metrics, "allocBytes", newNumber(r.allocBytes));
+    /* per input byte, counted over the measured runs */
+    for (int event = 0; event < COUNTER_EVENTS; ++event)
+    {
+        if (!counters.isOpen(event))
+            continue;
+        if (r.counts[event] < 0.0)
+        {
+            printf(" %9s", "-");
+            continue;
+        }
+        double perByte = r.counts[event] / doc.text.size();
+        printf(" %9.3f", perByte);
+        addMember(metrics, counterMetrics[event], newNumber(perByte));
+    }
+    printf("\n");
+
+    return;
+}
+
+/* arrays of strings only or numbers only, without member keys, 
+ * so that parse rows tell parseString and parseNumber apart */
+static std::string makeScalarArrays(bool strings)
+{
+    GenShape shape;
+    defaultShape(shape);
+    shape.size = BENCH_KERNEL_SIZE;
+    shape.objects = 0.0;
+    shape.literals = 0;
+    if (strings)
+        shape.integers = shape.decimals = shape.exponents = 0;
+    else
+        shape.strings = 0;
+    std::string text;
+    Generator(shape, strings ? 2 : 3).generate(text);
+
+    return text;
+}
+
+static bool loadFile(const char* path, std::string& text)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == nullptr)
+        return false;
+
+    char chunk[65536];
+    size_t len;
+    text.clear();
+    while ((len = fread(chunk, 1, sizeof(chunk), fp)) != 0)
+        text.append(chunk, len);
+    bool ret = (ferror(fp) == 0);
+    fclose(fp);
+
+    return ret;
+}
+#endif
+
+/* -------- latency -------- */
+#if 1
+/* one operation of a request, nanoseconds of each run */
+typedef struct
+{
+    const char* name;
+    std::vector<long long> nanos;
+    size_t allocs; /* over the allocation pass */
+    long long allocNanos; /* spent in the allocator during the allocation pass */
+    long long totalNanos; /* spent in the operation during the allocation pass */
+} Latency;
+
+enum { LATENCY_PARSE, LATENCY_STRINGIFY, LATENCY_DESTROY, LATENCY_REQUEST, LATENCY_OPS };
+
+/* keep this thread on one CPU, the one it runs on when cpu is negative */
+static bool pinCpu(int& cpu)
+{
+#ifdef __linux__
+    if (cpu < 0 && (cpu = sched_getcpu()) < 0)
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    if (cpu < 0)
+        cpu = (int)GetCurrentProcessorNumber();
+    return cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+/* request bodies of BENCH_LATENCY_MIN_SIZE to BENCH_LATENCY_MAX_SIZE bytes in the default shape */
+static std::vector<std::string> makeRequests(uint64_t seed)
+{
+    std::vector<std::string> pool(BENCH_LATENCY_POOL);
+    GenShape shape;
+    defaultShape(shape);
+    Random random(seed);
+    for (std::string& text : pool)
+    {
+        shape.size = random.between(BENCH_LATENCY_MIN_SIZE, BENCH_LATENCY_MAX_SIZE);
+        Generator(shape, random.next()).generate(text);
+    }
+
+    return pool;
+}
+
+/* nearest rank, of sorted nanos */
+static long long percentile(const std::vector<long long>& sorted, double p)
+{
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+
+    return sorted[std::max(rank, (size_t)1) - 1];
+}
+
+/* the cheapest of many back-to-back clock reads */
+static long long clockCost(void)
+{
+    long long best = 1000000;
+    for (unsigned int index = 0; index < 10000; ++index)
+    {
+        long long t0 = nanosNow();
+        best = std::min(best, nanosNow() - t0);
+    }
+
+    return best;
+}
+
+/* parse, answer and drop each request as a server would, ops[] gets the nanoseconds of each step */
+static void latencyPass(const std::vector<std::string>& pool, size_t requests, Latency* ops, bool record)
+{
+    Lept::Format compact('\t', 1, Lept::Newline::NONE);
+    std::string out;
+    for (size_t index = 0; index < requests; ++index)
+    {
+        long long t0 = nanosNow(), t1, t2;
+        {
+            Lept::Value v;
+            v.parse(pool[index % pool.size()].c_str());
+            t1 = nanosNow();
+            v.stringify(out, compact);
+            t2 = nanosNow();
+        }
+        long long t3 = nanosNow();
+        if (record)
+        {
+            ops[LATENCY_PARSE].nanos.push_back(t1 - t0);
+            ops[LATENCY_STRINGIFY].nanos.push_back(t2 - t1);
+            ops[LATENCY_DESTROY].nanos.push_back(t3 - t2);
+            ops[LATENCY_REQUEST].nanos.push_back(t3 - t0);
+        }
+    }
+
+    return;
+}
+
+/* counters at one point of a request */
+typedef struct
+{
+    long long time;
+    size_t allocs;
+    long long allocNanos;
+    size_t allocCalls;
+} Snapshot;
+
+static void snapshot(Snapshot& snap)
+{
+    size_t bytes;
+    snap.allocs = countAllocs(bytes);
+#if BENCH_ALLOC_TIMING
+    snap.allocNanos = allocNanos;
+    snap.allocCalls = allocCalls;
+#else
+    snap.allocNanos = 0;
+    snap.allocCalls = 0;
+#endif
+    snap.time = nanosNow();
+
+    return;
+}
+
+/* one more round over the pool counting the allocations of each step, 
+ * and timing them where the allocator is ours; cost is a clock read, taken off twice per allocator call */
+static void allocationPass(const std::vector<std::string>& pool, Latency* ops, long long cost)
+{
+    static const int from[LATENCY_OPS] = { 0, 1, 2, 0 }, to[LATENCY_OPS] = { 1, 2, 3, 3 };
+    Lept::Format compact('\t', 1, Lept::Newline::NONE);
+    std::string out;
+    for (const std::string& text : pool)
+    {
+        Snapshot snaps[4];
+#if BENCH_ALLOC_TIMING
+        allocTiming = true;
+#endif
+        snapshot(snaps[0]);
+        {
+            Lept::Value v;
+            v.parse(text.c_str());
+            snapshot(snaps[1]);
+            v.stringify(out, compact);
+            snapshot(snaps[2]);
+        }
+        snapshot(snaps[3]);
+#if BENCH_ALLOC_TIMING
+        allocTiming = false;
+#endif
+
+        for (int op = 0; op < LATENCY_OPS; ++op)
+        {
+            const Snapshot& first = snaps[from[op]];
+            const Snapshot& last = snaps[to[op]];
+            long long calls = (long long)(last.allocCalls - first.allocCalls);
+            ops[op].allocs += last.allocs - first.allocs;
+            ops[op].allocNanos += std::max(0LL, last.allocNanos - first.allocNanos - calls * cost);
+            ops[op].totalNanos += std::max(0LL, last.time - first.time - 2 * calls * cost);
+        }
+    }
+
+    return;
+}
+
+static int latency(const std::vector<std::string>& pool, size_t requests, unsigned int warmup, int cpu, Lept::Value& results)
+{
+    bool pinned = pinCpu(cpu);
+    size_t bytes = 0;
+    for (const std::string& text : pool)
+    {
+        Lept::Value v;
+        if (v.parse(text.c_str()) != Lept::PARSE_OK)
+        {
+            fprintf(stderr, "leptjson_bench: request %zu is not valid JSON\n", (size_t)(&text - &pool[0]));
+            return 1;
+        }
+        bytes += text.size();
+    }
+
+    Latency ops[LATENCY_OPS] = {
+        { "parse", std::vector<long long>(), 0, 0, 0 },
+        { "stringify", std::vector<long long>(), 0, 0, 0 },
+        { "destroy", std::vector<long long>(), 0, 0, 0 },
+        { "request", std::vector<long long>(), 0, 0, 0 }
+    };
+    for (Latency& op : ops)
+        op.nanos.reserve(requests);
+
+    /* the allocator has seen every request before the measured ones */
+    latencyPass(pool, warmup * pool.size(), ops, false);
+    latencyPass(pool, requests, ops, true);
+    long long cost = clockCost();
+    allocationPass(pool, ops, cost);
+
+    printf("%zu requests over %zu documents of %d to %d bytes, %zu on average, ", 
+        requests, pool.size(), BENCH_LATENCY_MIN_SIZE, BENCH_LATENCY_MAX_SIZE, bytes / pool.size());
+    if (pinned)
+        printf("pinned to CPU %d\n", cpu);
+    else
+        printf("not pinned\n");
+    printf("a clock read costs %lld ns and is included below\n", cost);
+    printf("%-10s %9s %9s %9s %9s %9s %9s %8s\n", "operation", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns", "allocs", "alloc %");
+    for (Latency& op : ops)
+    {
+        std::sort(op.nanos.begin(), op.nanos.end());
+        char share[16] = "-";
+        if (BENCH_ALLOC_TIMING && op.totalNanos > 0)
+            snprintf(share, sizeof(share), "%.1f", 100.0 * op.allocNanos / op.totalNanos);
+        long long p50 = percentile(op.nanos, 50.0), p90 = percentile(op.nanos, 90.0), p99 = percentile(op.nanos, 99.0), p999 = percentile(op.nanos, 99.9);
+        double allocs = (double)op.allocs / pool.size();
+        printf("%-10s %9lld %9lld %9lld %9lld %9lld %9.1f %8s\n", op.name, p50, p90, p99, p999, op.nanos.back(), allocs, share);
+
+        Lept::Value& metrics = addResult(results, "requests", op.name);
+        addMember(metrics, "p50", newNumber((double)p50));
+        addMember(metrics, "p90", newNumber((double)p90));
+        addMember(metrics, "p99", newNumber((double)p99));
+        addMember(metrics, "p99.9", newNumber((double)p999));
+        addMember(metrics, "max", newNumber((double)op.nanos.back()));
+        addMember(metrics, "allocs", newNumber(allocs));
+        if (BENCH_ALLOC_TIMING && op.totalNanos > 0)
+            addMember(metrics, "allocShare", newNumber((double)op.allocNanos / op.totalNanos));
+    }
+
+    return 0;
+}
+#endif
+
+static void usage(FILE* fp)
+{
+    fprintf(fp,
+        "usage: leptjson_bench [options] [file...]\n"
+        "  file                JSON document measured after the bundled twitter, canada and citm ones\n"
+        "                      and the strings and numbers ones, made of a single kind of scalar\n"
+        "  -n, --iterations N  measured runs per operation (default: 10)\n"
+        "  -w, --warmup N      unmeasured runs before them (default: 2)\n"
+        "  -g, --generate BYTES also measure a document from the default shape of leptjson_gen,\n"
+        "                      K, M and G suffixes are allowed\n"
+        "  -s, --seed N        seed of the generated documents (default: 1)\n"
+        "      --only          measure the given files and the generated document only\n"
+        "  -l, --latency N     parse, stringify and drop N small requests one by one instead,\n"
+        "                      reporting percentiles; the files are the requests when given,\n"
+        "                      generated ones of 200 to 4096 bytes otherwise; -w passes over\n"
+        "                      them warm the allocator first; alloc %% is the share of time\n"
+        "                      spent in operator new and delete, frees included\n"
+        "      --cpu N         CPU the latency mode runs on (default: the current one)\n"
+        "  -o, --output FILE   also write the results to FILE as JSON, for bench-compare\n"
+        "      --no-counters   leave out the hardware counters per input byte, which are read\n"
+        "                      through perf_event_open() on Linux where permitted\n"
+        "  -h, --help          show this help\n");
+
+    return;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int iterations = 10, warmup = 2;
+    bool only = false;
+    size_t generate = 0;
+    uint64_t seed = 1;
+    size_t requests = 0;
+    int cpu = -1;
+    const char* output = nullptr;
+    bool useCounters = true;
+    std::vector<const char*> files;
+    for (int index = 1; index < argc; ++index)
+    {
+        const char* arg = argv[index];
+        bool hasNext = (index + 1 < argc);
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        {
+            usage(stdout);
+            return 0;
+        }
+        else if ((!strcmp(arg, "-n") || !strcmp(arg, "--iterations")) && hasNext)
+            iterations = std::max(1, atoi(argv[++index]));
+        else if ((!strcmp(arg, "-w") || !strcmp(arg, "--warmup")) && hasNext)
+            warmup = (unsigned int)std::max(0, atoi(argv[++index]));
+        else if ((!strcmp(arg, "-g") || !strcmp(arg, "--generate")) && hasNext)
+        {
+            if (!parseByteSize(argv[++index], generate))
+            {
+                usage(stderr);
+                return 2;
+            }
+        }
+        else if ((!strcmp(arg, "-s") || !strcmp(arg, "--seed")) && hasNext)
+            seed = strtoull(argv[++index], nullptr, 10);
+        else if (!strcmp(arg, "--only"))
+            only = true;
+        else if ((!strcmp(arg, "-l") || !strcmp(arg, "--latency")) && hasNext)
+            requests = (size_t)std::max(1LL, atoll(argv[++index]));
+        else if (!strcmp(arg, "--cpu") && hasNext)
+            cpu = atoi(argv[++index]);
+        else if ((!strcmp(arg, "-o") || !strcmp(arg, "--output")) && hasNext)
+            output = argv[++index];
+        else if (!strcmp(arg, "--no-counters"))
+            useCounters = false;
+        else if (arg[0] == '-')
+        {
+            usage(stderr);
+            return 2;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    Lept::Value results(Lept::Type::ARRAY);
+    if (requests != 0)
+    {
+        std::vector<std::string> pool;
+        if (files.empty())
+            pool = makeRequests(seed);
+        for (const char* file : files)
+        {
+            pool.push_back(std::string());
+            if (!loadFile(file, pool.back()))
+            {
+                fprintf(stderr, "leptjson_bench: %s: cannot read input\n", file);
+                return 1;
+            }
+        }
+#ifndef NDEBUG
+        fprintf(stderr, "leptjson_bench: assertions are on, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n");
+#endif
+        int ret = latency(pool, requests, warmup, cpu, results);
+        if (ret == 0 && output != nullptr && !writeResults(output, results, requests, warmup))
+        {
+            fprintf(stderr, "leptjson_bench: %s: cannot write results\n", output);
+            ret = 1;
+        }
+        return ret;
+    }
+
+    std::vector<Document> docs;
+    if (!only)
+    {
+        docs.push_back(Document{ "twitter", makeTwitter(), 0 });
+        docs.push_back(Document{ "canada", makeCanada(), 0 });
+        docs.push_back(Document{ "citm", makeCitm(), 0 });
+        docs.push_back(Document{ "strings", makeScalarArrays(true), 0 });
+        docs.push_back(Document{ "numbers", makeScalarArrays(false), 0 });
+    }
+    if (generate != 0)
+    {
+        GenShape shape;
+        defaultShape(shape);
+        shape.size = generate;
+        Document doc{ "generated", std::string(), 0 };
+        Generator(shape, seed).generate(doc.text);
+        docs.push_back(doc);
+    }
+    for (const char* file : files)
+    {
+        Document doc{ file, std::string(), 0 };
+        const char* slash = strrchr(file, '/');
+        doc.name = (slash != nullptr) ? slash + 1 : file;
+        if (!loadFile(file, doc.text))
+        {
+            fprintf(stderr, "leptjson_bench: %s: cannot read input\n", file);
+            return 1;
+        }
+        docs.push_back(doc);
+    }
+
+#ifndef NDEBUG
+    fprintf(stderr, "leptjson_bench: assertions are on, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n");
+#endif
+    HardwareCounters counters(useCounters);
+    if (useCounters && !counters.isAnyOpen())
+        fprintf(stderr, "leptjson_bench: hardware counters unavailable (%s), see /proc/sys/kernel/perf_event_paranoid\n", strerror(counters.getError()));
+    printf("%u warmup and %u measured runs per operation, MB/s of input text\n", warmup, iterations);
+    printf("%-10s %-17s %9s %9s %9s %12s %12s", "document", "operation", "MB/s", "best MB/s", "ns/node", "allocs/doc", "bytes/doc");
+    for (int event = 0; event < COUNTER_EVENTS; ++event)
+    {
+        if (counters.isOpen(event))
+            printf(" %9s", counterColumns[event]);
+    }
+    printf("\n");
+
+    int ret = 0;
+    Lept::Format pretty, compact('\t', 1, Lept::Newline::NONE);
+    for (Document& doc : docs)
+    {
+        Lept::Value v;
+        if (v.parse(doc.text.c_str()) != Lept::PARSE_OK)
+        {
+            fprintf(stderr, "leptjson_bench: %s: not valid JSON, skipped\n", doc.name.c_str());
+            ret = 1;
+            continue;
+        }
+        doc.nodes = countNodes(v);
+        printf("%-10s %zu bytes, %zu nodes\n", doc.name.c_str(), doc.text.size(), doc.nodes);
+
+        /* the tree of each parse is freed outside the measured part */
+        std::vector<Lept::Value*> trees;
+        for (unsigned int index = 0; index < warmup + iterations; ++index)
+            trees.push_back(new Lept::Value());
+        size_t run = 0;
+        report(doc, "parse", results, counters, measure(counters, warmup, iterations, [&]() { trees[run++]->parse(doc.text.c_str()); }));
+        for (Lept::Value* tree : trees)
+            delete tree;
+
+        std::string out;
+        report(doc, "stringify pretty", results, counters, measure(counters, warmup, iterations, [&]() { v.stringify(out, pretty); }));
+        report(doc, "stringify compact", results, counters, measure(counters, warmup, iterations, [&]() { v.stringify(out, compact); }));
+        report(doc, "round trip", results, counters, measure(counters, warmup, iterations, [&]() {
+            Lept::Value tree;
+            tree.parse(doc.text.c_str());
+            tree.stringify(out, compact);
+        }));
+    }
+    if (output != nullptr && !writeResults(output, results, iterations, warmup))
+    {
+        fprintf(stderr, "leptjson_bench: %s: cannot write results\n", output);
+        ret = 1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,248 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath> /* HUGE_VAL */
+#include <string>
+#include <vector>
+#include <algorithm> /* std::sort() */
+#include "leptjson.h"
+
+/* change in percent beyond which a metric counts as regressed */
+#define COMPARE_THRESHOLD 5.0
+
+/* one metric of one result, from every file of both sides */
+typedef struct
+{
+    std::string document;
+    std::string operation;
+    std::string name;
+    std::vector<double> base;
+    std::vector<double> candidate;
+} Metric;
+
+static void usage(FILE* fp)
+{
+    fprintf(fp,
+        "usage: bench-compare [options] BASE CANDIDATE\n"
+        "       bench-compare [options] BASE... -- CANDIDATE...\n"
+        "  BASE, CANDIDATE     result files of leptjson_bench -o, the median of each metric\n"
+        "                      over the files of a side is compared\n"
+        "  -t, --threshold PCT change that counts as a regression (default: 5)\n"
+        "      --ignore METRIC leave METRIC out, such as allocBytes, may be repeated\n"
+        "      --all           also compare max and best* metrics, the extremes of a run,\n"
+        "                      which vary too much between runs to gate by default\n"
+        "  -h, --help          show this help\n"
+        "by default mbps, nsPerNode, allocs, allocBytes, the hardware counters per byte,\n"
+        "the latency percentiles and allocShare are compared\n"
+        "exits with 1 if a compared metric regressed, 2 on unreadable input\n");
+
+    return;
+}
+
+static bool loadFile(const char* path, std::string& text)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == nullptr)
+        return false;
+
+    char chunk[65536];
+    size_t len;
+    text.clear();
+    while ((len = fread(chunk, 1, sizeof(chunk), fp)) != 0)
+        text.append(chunk, len);
+    bool ret = (ferror(fp) == 0);
+    fclose(fp);
+
+    return ret;
+}
+
+/* value of key in obj, nullptr if obj is no object or has no such member */
+static const Lept::Value* findMember(const Lept::Value& obj, const char* key)
+{
+    if (obj.getType() != Lept::Type::OBJECT)
+        return nullptr;
+    for (const Lept::Member* member : *obj.getObj())
+    {
+        if (*member->key == key)
+            return member->value;
+    }
+
+    return nullptr;
+}
+
+static bool isType(const Lept::Value* v, Lept::Type type)
+{
+    return v != nullptr && v->getType() == type;
+}
+
+static Metric& findMetric(std::vector<Metric>& metrics, const std::string& document, const std::string& operation, const std::string& name)
+{
+    for (Metric& metric : metrics)
+    {
+        if (metric.document == document && metric.operation == operation && metric.name == name)
+            return metric;
+    }
+    metrics.push_back(Metric{ document, operation, name, std::vector<double>(), std::vector<double>() });
+
+    return metrics.back();
+}
+
+/* max and best*: single extremes rather than medians or per-run averages */
+static bool isExtreme(const std::string& name)
+{
+    return name == "max" || name.compare(0, 4, "best") == 0;
+}
+
+/* adds the metrics of one result file to one side, false if it cannot be read */
+static bool readResults(const char* path, bool candidate, bool all, const std::vector<const char*>& ignored, std::vector<Metric>& metrics)
+{
+    std::string text;
+    if (!loadFile(path, text))
+    {
+        fprintf(stderr, "bench-compare: %s: cannot read input\n", path);
+        return false;
+    }
+    Lept::Value root;
+    if (root.parse(text.c_str()) != Lept::PARSE_OK)
+    {
+        fprintf(stderr, "bench-compare: %s: not valid JSON\n", path);
+        return false;
+    }
+    const Lept::Value* results = findMember(root, "results");
+    if (!isType(results, Lept::Type::ARRAY))
+    {
+        fprintf(stderr, "bench-compare: %s: not a result file of leptjson_bench -o\n", path);
+        return false;
+    }
+
+    for (const Lept::Value* result : *results->getArr())
+    {
+        const Lept::Value* document = findMember(*result, "document");
+        const Lept::Value* operation = findMember(*result, "operation");
+        const Lept::Value* values = findMember(*result, "metrics");
+        if (!isType(document, Lept::Type::STRING) || !isType(operation, Lept::Type::STRING) || !isType(values, Lept::Type::OBJECT))
+        {
+            fprintf(stderr, "bench-compare: %s: result without document, operation or metrics\n", path);
+            return false;
+        }
+        for (const Lept::Member* member : *values->getObj())
+        {
+            bool skip = !isType(member->value, Lept::Type::NUMBER) || (!all && isExtreme(*member->key));
+            for (const char* name : ignored)
+                skip = skip || (*member->key == name);
+            if (skip)
+                continue;
+            Metric& metric = findMetric(metrics, *document->getStr(), *operation->getStr(), *member->key);
+            (candidate ? metric.candidate : metric.base).push_back(member->value->getNum());
+        }
+    }
+
+    return true;
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t mid = values.size() / 2;
+
+    return (values.size() % 2 != 0) ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+/* throughput is better higher, times, allocations and shares lower */
+static bool higherIsBetter(const std::string& name)
+{
+    const char suffix[] = "Mbps";
+    size_t len = sizeof(suffix) - 1;
+
+    return name == "mbps" || (name.size() >= len && name.compare(name.size() - len, len, suffix) == 0);
+}
+
+int main(int argc, char* argv[])
+{
+    double threshold = COMPARE_THRESHOLD;
+    std::vector<const char*> ignored, base, candidate;
+    bool separated = false, all = false;
+    for (int index = 1; index < argc; ++index)
+    {
+        const char* arg = argv[index];
+        bool hasNext = (index + 1 < argc);
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        {
+            usage(stdout);
+            return 0;
+        }
+        else if ((!strcmp(arg, "-t") || !strcmp(arg, "--threshold")) && hasNext)
+            threshold = atof(argv[++index]);
+        else if (!strcmp(arg, "--ignore") && hasNext)
+            ignored.push_back(argv[++index]);
+        else if (!strcmp(arg, "--all"))
+            all = true;
+        else if (!strcmp(arg, "--") && !separated)
+            separated = true;
+        else if (arg[0] == '-' && arg[1] != '\0')
+        {
+            usage(stderr);
+            return 2;
+        }
+        else
+            (separated ? candidate : base).push_back(arg);
+    }
+    if (!separated && base.size() == 2)
+    {
+        candidate.push_back(base.back());
+        base.pop_back();
+    }
+    if (base.empty() || candidate.empty() || threshold < 0.0)
+    {
+        usage(stderr);
+        return 2;
+    }
+
+    std::vector<Metric> metrics;
+    for (const char* path : base)
+    {
+        if (!readResults(path, false, all, ignored, metrics))
+            return 2;
+    }
+    for (const char* path : candidate)
+    {
+        if (!readResults(path, true, all, ignored, metrics))
+            return 2;
+    }
+
+    size_t compared = 0, regressed = 0;
+    printf("median of %zu base and %zu candidate runs, regressions beyond %.1f%%\n", base.size(), candidate.size(), threshold);
+    printf("%-12s %-17s %-10s %14s %14s %9s\n", "document", "operation", "metric", "base", "candidate", "change");
+    for (const Metric& metric : metrics)
+    {
+        if (metric.base.empty() || metric.candidate.empty())
+        {
+            printf("%-12s %-17s %-10s only in the %s\n", metric.document.c_str(), metric.operation.c_str(), metric.name.c_str(),
+                metric.base.empty() ? "candidate" : "base");
+            continue;
+        }
+
+        double before = median(metric.base), after = median(metric.candidate);
+        /* in percent, positive when the candidate is worse */
+        double change = 0.0, worse = 0.0;
+        if (before != 0.0)
+            change = (after - before) / std::fabs(before) * 100.0;
+        else if (after != 0.0)
+            change = (after > 0.0) ? HUGE_VAL : -HUGE_VAL;
+        worse = higherIsBetter(metric.name) ? -change : change;
+
+        const char* verdict = "";
+        if (worse > threshold)
+            verdict = "  regressed";
+        else if (worse < -threshold)
+            verdict = "  improved";
+        ++compared;
+        regressed += (worse > threshold);
+        printf("%-12s %-17s %-10s %14.6g %14.6g %+8.1f%%%s\n", metric.document.c_str(), metric.operation.c_str(), metric.name.c_str(),
+            before, after, change, verdict);
+    }
+    printf("%zu of %zu metrics regressed\n", regressed, compared);
+
+    return (regressed != 0) ? 1 : 0;
+}
@@ -0,0 +1,630 @@
+#include "generator.h"
+#include <cstdlib> /* strtoull() */
+#include <cctype> /* toupper() */
+#include <cstdio> /* snprintf() */
+
+/* macros */
+#if 1
+/* scalar kinds, in the order of their weights in GenShape */
+#define GEN_STRING 0
+#define GEN_INTEGER 1
+#define GEN_DECIMAL 2
+#define GEN_EXPONENT 3
+#define GEN_LITERAL 4
+#endif
+
+
+/* -------- Random -------- */
+#if 1
+// Constructor;
+Random::Random(uint64_t seed) :
+    m_state(seed != 0 ? seed : 1)
+{
+
+}
+
+uint64_t Random::next(void)
+{
+    this->m_state ^= this->m_state >> 12;
+    this->m_state ^= this->m_state << 25;
+    this->m_state ^= this->m_state >> 27;
+    return this->m_state * 2685821657736338717ULL;
+}
+unsigned int Random::below(unsigned int bound)
+{
+    return (unsigned int)(this->next() % bound);
+}
+unsigned int Random::between(unsigned int min, unsigned int max)
+{
+    return (max > min) ? min + this->below(max - min + 1) : min;
+}
+double Random::unit(void)
+{
+    return (double)(this->next() >> 11) / 9007199254740992.0;
+}
+const char* Random::pick(const char* const* words, size_t count)
+{
+    return words[this->below((unsigned int)count)];
+}
+#endif
+
+
+/* -------- shape -------- */
+#if 1
+void defaultShape(GenShape& shape)
+{
+    shape.maxDepth = 6;
+    shape.minWidth = 1;
+    shape.maxWidth = 8;
+    shape.minLength = 0;
+    shape.maxLength = 16;
+    shape.minString = 0;
+    shape.maxString = 32;
+    shape.minKey = 1;
+    shape.maxKey = 12;
+    shape.escapes = 0.02;
+    shape.unicode = 0.01;
+    shape.utf8 = 0.05;
+    shape.containers = 0.3;
+    shape.objects = 0.6;
+    shape.strings = 4;
+    shape.integers = 3;
+    shape.decimals = 2;
+    shape.exponents = 1;
+    shape.literals = 1;
+    shape.size = 0;
+
+    return;
+}
+
+bool parseByteSize(const char* text, size_t& size)
+{
+    char* end;
+    if (*text < '0' || *text > '9')
+        return false;
+    unsigned long long num = strtoull(text, &end, 10);
+    switch (toupper((unsigned char)*end))
+    {
+    case '\0': break;
+    case 'K': num <<= 10; ++end; break;
+    case 'M': num <<= 20; ++end; break;
+    case 'G': num <<= 30; ++end; break;
+    default: return false;
+    }
+    if (*end != '\0')
+        return false;
+    size = (size_t)num;
+
+    return true;
+}
+#endif
+
+
+/* -------- Generator -------- */
+#if 1
+// Constructor;
+Generator::Generator(const GenShape& shape, uint64_t seed) :
+    m_shape(shape),
+    m_random(seed),
+    m_limit(0)
+{
+
+}
+
+/* get-Functions */
+const GenShape& Generator::getShape(void) const
+{
+    return this->m_shape;
+}
+
+bool Generator::full(const std::string& out) const
+{
+    return this->m_limit != 0 && out.size() >= this->m_limit;
+}
+
+void Generator::generate(std::string& out)
+{
+    if (this->m_shape.size == 0)
+    {
+        this->m_limit = 0;
+        if (this->m_shape.maxDepth == 0)
+            this->value(out, 1);
+        else if (this->m_random.unit() < this->m_shape.objects)
+            this->object(out, 1);
+        else
+            this->array(out, 1);
+        return;
+    }
+
+    /* elements are added until the size is reached, the last one is cut short by full() */
+    this->m_limit = out.size() + this->m_shape.size;
+    out += '[';
+    for (bool first = true; !this->full(out); first = false)
+    {
+        if (!first)
+            out += ',';
+        this->value(out, 2);
+    }
+    out += ']';
+
+    return;
+}
+
+void Generator::value(std::string& out, unsigned int level)
+{
+    const GenShape& shape = this->m_shape;
+    if (level <= shape.maxDepth && this->m_random.unit() < shape.containers)
+    {
+        if (this->m_random.unit() < shape.objects)
+            this->object(out, level);
+        else
+            this->array(out, level);
+        return;
+    }
+
+    const unsigned int weights[] = { shape.strings, shape.integers, shape.decimals, shape.exponents, shape.literals };
+    unsigned int total = 0, kind = 0;
+    for (unsigned int weight : weights)
+        total += weight;
+    if (total == 0)
+    {
+        out += "null";
+        return;
+    }
+    for (unsigned int roll = this->m_random.below(total); roll >= weights[kind]; ++kind)
+        roll -= weights[kind];
+
+    if (kind == GEN_STRING)
+        this->string(out, shape.minString, shape.maxString);
+    else if (kind == GEN_LITERAL)
+    {
+        static const char* const literals[] = { "true", "false", "null" };
+        out += this->m_random.pick(literals, 3);
+    }
+    else
+        this->number(out, kind);
+
+    return;
+}
+
+void Generator::array(std::string& out, unsigned int level)
+{
+    unsigned int len = this->m_random.between(this->m_shape.minLength, this->m_shape.maxLength);
+    out += '[';
+    for (unsigned int index = 0; index < len && !this->full(out); ++index)
+    {
+        if (index != 0)
+            out += ',';
+        this->value(out, level + 1);
+    }
+    out += ']';
+
+    return;
+}
+
+/* keys are random, duplicates are possible on short key ranges as in real traffic */
+void Generator::object(std::string& out, unsigned int level)
+{
+    unsigned int len = this->m_random.between(this->m_shape.minWidth, this->m_shape.maxWidth);
+    out += '{';
+    for (unsigned int index = 0; index < len && !this->full(out); ++index)
+    {
+        if (index != 0)
+            out += ',';
+        this->string(out, this->m_shape.minKey, this->m_shape.maxKey);
+        out += ':';
+        this->value(out, level + 1);
+    }
+    out += '}';
+
+    return;
+}
+
+static void appendUtf8(std::string& out, unsigned int u)
+{
+    if (u <= 0x7F)
+        out += (char)u;
+    else if (u <= 0x7FF)
+    {
+        out += (char)(0xC0 | (u >> 6));
+        out += (char)(0x80 | (u & 0x3F));
+    }
+    else if (u <= 0xFFFF)
+    {
+        out += (char)(0xE0 | (u >> 12));
+        out += (char)(0x80 | ((u >> 6) & 0x3F));
+        out += (char)(0x80 | (u & 0x3F));
+    }
+    else
+    {
+        out += (char)(0xF0 | (u >> 18));
+        out += (char)(0x80 | ((u >> 12) & 0x3F));
+        out += (char)(0x80 | ((u >> 6) & 0x3F));
+        out += (char)(0x80 | (u & 0x3F));
+    }
+
+    return;
+}
+static void appendHex4(std::string& out, unsigned int u)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += "\\u";
+    for (int shift = 12; shift >= 0; shift -= 4)
+        out += hex[(u >> shift) & 0xF];
+
+    return;
+}
+
+void Generator::string(std::string& out, unsigned int minLen, unsigned int maxLen)
+{
+    static const char plain[] = "abcdefghijklmnopqrstuvwxyz eeaaoo iinnt ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789_-.,:/";
+    static const char* const escapes[] = { "\\\"", "\\\\", "\\/", "\\b", "\\f", "\\n", "\\r", "\\t" };
+    const GenShape& shape = this->m_shape;
+    Random& random = this->m_random;
+
+    double skew = random.unit();
+    unsigned int len = minLen + (unsigned int)(skew * skew * (maxLen >= minLen ? maxLen - minLen + 1 : 0));
+    out += '"';
+    for (unsigned int index = 0; index < len; ++index)
+    {
+        double roll = random.unit();
+        if (roll < shape.escapes)
+            out += random.pick(escapes, sizeof(escapes) / sizeof(escapes[0]));
+        else if ((roll -= shape.escapes) < shape.unicode)
+        {
+            if (random.below(4) == 0)
+            {
+                unsigned int u = random.below(0x100000);
+                appendHex4(out, 0xD800 + (u >> 10));
+                appendHex4(out, 0xDC00 + (u & 0x3FF));
+            }
+            else
+                appendHex4(out, 1 + random.below(0xD7FF));
+        }
+        else if ((roll -= shape.unicode) < shape.utf8)
+        {
+            unsigned int u;
+            switch (random.below(3))
+            {
+            case 0: u = 0x80 + random.below(0x780); break;
+            case 1: u = 0x800 + random.below(0xD000); break; /* below the surrogates */
+            default: u = 0x10000 + random.below(0x100000); break;
+            }
+            appendUtf8(out, u);
+        }
+        else
+            out += plain[random.below(sizeof(plain) - 1)];
+    }
+    out += '"';
+
+    return;
+}
+
+/* count digits, the first one non-zero when leading */
+void Generator::digits(std::string& out, unsigned int count, bool leading)
+{
+    for (unsigned int index = 0; index < count; ++index)
+        out += (char)('0' + ((leading && index == 0) ? 1 + this->m_random.below(9) : this->m_random.below(10)));
+
+    return;
+}
+
+void Generator::number(std::string& out, unsigned int kind)
+{
+    Random& random = this->m_random;
+    if (random.below(4) == 0)
+        out += '-';
+
+    double skew = random.unit();
+    if (kind == GEN_INTEGER)
+        this->digits(out, 1 + (unsigned int)(skew * skew * 19), true);
+    else if (kind == GEN_DECIMAL)
+    {
+        unsigned int whole = (unsigned int)(skew * 7);
+        if (whole == 0)
+            out += '0';
+        else
+            this->digits(out, whole, true);
+        out += '.';
+        this->digits(out, random.between(1, 17), false);
+    }
+    else
+    {
+        this->digits(out, 1, true);
+        if (random.below(2) != 0)
+        {
+            out += '.';
+            this->digits(out, random.between(1, 16), false);
+        }
+        out += random.below(2) ? 'e' : 'E';
+        unsigned int sign = random.below(3);
+        if (sign != 0)
+            out += (sign == 1) ? '-' : '+';
+        out += std::to_string(random.below(301));
+    }
+
+    return;
+}
+#endif
+
+
+/* -------- benchmark documents -------- */
+#if 1
+static void appendNumber(std::string& out, double num)
+{
+    char buffer[32];
+    out.append(buffer, (size_t)snprintf(buffer, sizeof(buffer), "%.17g", num));
+
+    return;
+}
+static void appendInteger(std::string& out, long long num)
+{
+    out += std::to_string(num);
+
+    return;
+}
+static void appendKey(std::string& out, const char* key)
+{
+    out.append("\"").append(key).append("\":");
+
+    return;
+}
+
+/* words of tweets and catalog names, raw UTF-8 and escapes as found in such feeds */
+static const char* const textWords[] = {
+    "the", "json", "parser", "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF", "\\u3042\\u308a\\u304c\\u3068\\u3046",
+    "release", "@lept", "#cpp", "http:\\/\\/t.co\\/x1Yz", "\\\"quoted\\\"", "\xF0\x9F\x98\x80", "\\ud83d\\ude80", "fast",
+    "line\\nbreak", "caf\xC3\xA9", "stream", "benchmark", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E", "memory", "&amp;"
+};
+static const char* const nameWords[] = {
+    "Salle", "Pleyel", "Orchestre", "Philharmonique", "Concert", "Arri\xC3\xA8re-sc\xC3\xA8ne", "Balcon", "Parterre",
+    "Op\xC3\xA9ra", "Bastille", "Quatuor", "R\xC3\xA9" "cital", "Jazz", "Symphonie", "Loge", "Central", "Gauche", "Droite"
+};
+
+static void appendText(std::string& out, Random& random, const char* const* words, size_t count, unsigned int minWords, unsigned int maxWords)
+{
+    unsigned int len = minWords + random.below(maxWords - minWords + 1);
+    out += '"';
+    for (unsigned int index = 0; index < len; ++index)
+    {
+        if (index != 0)
+            out += ' ';
+        out += random.pick(words, count);
+    }
+    out += '"';
+
+    return;
+}
+
+std::string indentJson(const std::string& json, unsigned int width)
+{
+    std::string out;
+    size_t level = 0;
+    bool inString = false, escaped = false;
+    out.reserve(json.size() * 2);
+    for (size_t index = 0; index < json.size(); ++index)
+    {
+        char ch = json[index];
+        if (inString)
+        {
+            out += ch;
+            if (escaped)
+                escaped = false;
+            else if (ch == '\\')
+                escaped = true;
+            else if (ch == '"')
+                inString = false;
+            continue;
+        }
+        switch (ch)
+        {
+        case '[':
+        case '{':
+            out += ch;
+            ++level;
+            if (json[index + 1] != ']' && json[index + 1] != '}') /* the closing bracket breaks the line itself */
+            {
+                out += '\n';
+                out.append(level * width, ' ');
+            }
+            break;
+        case ']':
+        case '}':
+            out += '\n';
+            out.append(--level * width, ' ');
+            out += ch;
+            break;
+        case ',':
+            out += ",\n";
+            out.append(level * width, ' ');
+            break;
+        case '"':
+            inString = true;
+            out += ch;
+            break;
+        default:
+            out += ch;
+            break;
+        }
+    }
+
+    return out;
+}
+
+/* search results of a social feed: three hundred statuses with their users,
+ * deep and wide objects, mostly strings, many nulls and booleans */
+std::string makeTwitter(void)
+{
+    Random random(0x7417);
+    std::string out = "{\"statuses\":[";
+    const size_t textCount = sizeof(textWords) / sizeof(textWords[0]);
+
+    for (int status = 0; status < 300; ++status)
+    {
+        long long id = 505874924095815681LL + random.below(1000000);
+        long long userId = 1186275104LL + random.below(100000000);
+        out += (status != 0) ? ",{" : "{";
+        out += "\"metadata\":{\"result_type\":\"recent\",\"iso_language_code\":\"ja\"},";
+        out += "\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",";
+        appendKey(out, "id"); appendInteger(out, id); out += ',';
+        appendKey(out, "id_str"); out += '"' + std::to_string(id) + "\",";
+        appendKey(out, "text"); appendText(out, random, textWords, textCount, 4, 24); out += ',';
+        out += "\"source\":\"<a href=\\\"http:\\/\\/twitter.com\\/download\\/iphone\\\" rel=\\\"nofollow\\\">Twitter for iPhone<\\/a>\",";
+        out += "\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_status_id_str\":null,";
+        out += "\"in_reply_to_user_id\":null,\"in_reply_to_user_id_str\":null,\"in_reply_to_screen_name\":null,";
+
+        out += "\"user\":{";
+        appendKey(out, "id"); appendInteger(out, userId); out += ',';
+        appendKey(out, "id_str"); out += '"' + std::to_string(userId) + "\",";
+        appendKey(out, "name"); appendText(out, random, textWords, textCount, 1, 3); out += ',';
+        out += "\"screen_name\":\"user_" + std::to_string(random.below(100000)) + "\",";
+        appendKey(out, "location"); appendText(out, random, textWords, textCount, 0, 2); out += ',';
+        appendKey(out, "description"); appendText(out, random, textWords, textCount, 5, 30); out += ',';
+        out += "\"url\":null,\"entities\":{\"description\":{\"urls\":[]}},\"protected\":false,";
+        appendKey(out, "followers_count"); appendInteger(out, random.below(5000)); out += ',';
+        appendKey(out, "friends_count"); appendInteger(out, random.below(5000)); out += ',';
+        appendKey(out, "listed_count"); appendInteger(out, random.below(50)); out += ',';
+        out += "\"created_at\":\"Fri Feb 22 06:53:38 +0000 2013\",";
+        appendKey(out, "favourites_count"); appendInteger(out, random.below(20000)); out += ',';
+        out += "\"utc_offset\":null,\"time_zone\":null,\"geo_enabled\":false,\"verified\":false,";
+        appendKey(out, "statuses_count"); appendInteger(out, random.below(100000)); out += ',';
+        out += "\"lang\":\"ja\",\"contributors_enabled\":false,\"is_translator\":false,\"is_translation_enabled\":false,";
+        out += "\"profile_background_color\":\"C0DEED\",";
+        out += "\"profile_background_image_url\":\"http:\\/\\/abs.twimg.com\\/images\\/themes\\/theme1\\/bg.png\",";
+        out += "\"profile_image_url\":\"http:\\/\\/pbs.twimg.com\\/profile_images\\/" + std::to_string(random.below(1000000000)) + "\\/normal.jpeg\",";
+        out += "\"profile_link_color\":\"0084B4\",\"profile_sidebar_border_color\":\"C0DEED\",\"profile_use_background_image\":true,";
+        out += "\"default_profile\":true,\"default_profile_image\":false,\"following\":false,\"follow_request_sent\":false,\"notifications\":false},";
+
+        out += "\"geo\":null,\"coordinates\":null,\"place\":null,\"contributors\":null,";
+        appendKey(out, "retweet_count"); appendInteger(out, random.below(1000)); out += ',';
+        appendKey(out, "favorite_count"); appendInteger(out, random.below(1000)); out += ',';
+        out += "\"entities\":{\"hashtags\":[";
+        for (unsigned int tag = 0, tags = random.below(3); tag < tags; ++tag)
+        {
+            unsigned int at = random.below(100);
+            out += (tag != 0) ? ",{" : "{";
+            appendKey(out, "text"); appendText(out, random, textWords, textCount, 1, 1);
+            out += ",\"indices\":[" + std::to_string(at) + "," + std::to_string(at + 5) + "]}";
+        }
+        out += "],\"symbols\":[],\"urls\":[],\"user_mentions\":[";
+        for (unsigned int mention = 0, mentions = random.below(3); mention < mentions; ++mention)
+        {
+            long long mentionId = 2000000000LL + random.below(100000000);
+            out += (mention != 0) ? ",{" : "{";
+            out += "\"screen_name\":\"user_" + std::to_string(random.below(100000)) + "\",";
+            appendKey(out, "name"); appendText(out, random, textWords, textCount, 1, 2); out += ',';
+            appendKey(out, "id"); appendInteger(out, mentionId); out += ',';
+            appendKey(out, "id_str"); out += '"' + std::to_string(mentionId) + "\",";
+            out += "\"indices\":[3,14]}";
+        }
+        out += "]},\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\"}";
+    }
+    out += "],\"search_metadata\":{\"completed_in\":0.087,\"max_id\":505874924095815681,\"max_id_str\":\"505874924095815681\",";
+    out += "\"next_results\":\"?max_id=505874847260352512&q=%E4%B8%80&count=100&include_entities=1\",";
+    out += "\"query\":\"%E4%B8%80\",\"refresh_url\":\"?since_id=505874924095815681&q=%E4%B8%80&include_entities=1\",";
+    out += "\"count\":300,\"since_id\":0,\"since_id_str\":\"0\"}}";
+
+    return out;
+}
+
+/* a country outline as GeoJSON: one feature, hundreds of rings,
+ * over a hundred thousand [longitude, latitude] pairs of full-precision decimals */
+std::string makeCanada(void)
+{
+    Random random(0xCA);
+    std::string out = "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\",\"properties\":{\"name\":\"Canada\"},";
+    out += "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[";
+
+    for (int ring = 0; ring < 240; ++ring)
+    {
+        double longitude = -141.0 + random.unit() * 88.0, latitude = 42.0 + random.unit() * 41.0;
+        unsigned int points = 20 + random.below(420);
+        out += (ring != 0) ? ",[" : "[";
+        for (unsigned int point = 0; point < points; ++point)
+        {
+            longitude += (random.unit() - 0.5) * 0.02;
+            latitude += (random.unit() - 0.5) * 0.02;
+            out += (point != 0) ? ",[" : "[";
+            appendNumber(out, longitude);
+            out += ',';
+            appendNumber(out, latitude);
+            out += ']';
+        }
+        out += ']';
+    }
+    out += "]}}]}";
+
+    return out;
+}
+
+/* a ticketing catalog: id-keyed name tables and performances with prices and seat areas,
+ * mostly integers and short arrays, indented like the exports it imitates */
+std::string makeCitm(void)
+{
+    Random random(0xC17A);
+    std::string out = "{";
+    const size_t nameCount = sizeof(nameWords) / sizeof(nameWords[0]);
+    const char* const tables[] = { "areaNames", "audienceSubCategoryNames", "blockNames", "seatCategoryNames", "subTopicNames", "subjectNames", "topicNames" };
+    const unsigned int tableSizes[] = { 17, 1, 0, 64, 19, 0, 4 };
+
+    for (size_t table = 0; table < sizeof(tables) / sizeof(tables[0]); ++table)
+    {
+        appendKey(out, tables[table]);
+        out += '{';
+        for (unsigned int index = 0; index < tableSizes[table]; ++index)
+        {
+            out += (index != 0) ? ",\"" : "\"";
+            out += std::to_string(205705993 + index * 6 + table) + "\":";
+            appendText(out, random, nameWords, nameCount, 1, 3);
+        }
+        out += "},";
+    }
+
+    out += "\"events\":{";
+    for (int event = 0; event < 184; ++event)
+    {
+        long long id = 138586341 + event * 2;
+        out += (event != 0) ? ",\"" : "\"";
+        out += std::to_string(id) + "\":{\"description\":null,";
+        appendKey(out, "id"); appendInteger(out, id); out += ',';
+        out += random.below(3) != 0 ? "\"logo\":null," : "\"logo\":\"/images/UE0AAAAACEKo6QAAAAZDSVRN\",";
+        appendKey(out, "name"); appendText(out, random, nameWords, nameCount, 1, 5); out += ',';
+        out += "\"subTopicIds\":[337184269,337184283],\"subjectCode\":null,\"subtitle\":null,\"topicIds\":[324846099,107888604]}";
+    }
+    out += "},\"performances\":[";
+    for (int performance = 0; performance < 243; ++performance)
+    {
+        out += (performance != 0) ? ",{" : "{";
+        appendKey(out, "eventId"); appendInteger(out, 138586341 + random.below(184) * 2); out += ',';
+        appendKey(out, "id"); appendInteger(out, 339887544 + performance); out += ',';
+        out += "\"logo\":null,\"name\":null,\"prices\":[";
+        for (unsigned int price = 0, prices = 1 + random.below(6); price < prices; ++price)
+        {
+            out += (price != 0) ? ",{" : "{";
+            appendKey(out, "amount"); appendInteger(out, 9000 + random.below(180) * 500); out += ',';
+            out += "\"audienceSubCategoryId\":337100890,";
+            appendKey(out, "seatCategoryId"); appendInteger(out, 338937295 + random.below(64)); out += '}';
+        }
+        out += "],\"seatCategories\":[";
+        for (unsigned int category = 0, categories = 1 + random.below(6); category < categories; ++category)
+        {
+            out += (category != 0) ? ",{\"areas\":[" : "{\"areas\":[";
+            for (unsigned int area = 0, areas = 1 + random.below(12); area < areas; ++area)
+            {
+                out += (area != 0) ? ",{" : "{";
+                appendKey(out, "areaId"); appendInteger(out, 205705993 + random.below(17) * 6); out += ",\"blockIds\":[]}";
+            }
+            out += "],";
+            appendKey(out, "seatCategoryId"); appendInteger(out, 338937295 + random.below(64)); out += '}';
+        }
+        out += "],\"seatMapImage\":null,";
+        appendKey(out, "start"); appendInteger(out, 1372701600000LL + (long long)random.below(1000) * 86400000LL); out += ',';
+        out += "\"venueCode\":\"PLEYEL_PLEYEL\"}";
+    }
+    out += "],\"topicSubTopics\":{\"324846099\":[337184269,337184283],\"107888604\":[337184263,337184267]},";
+    out += "\"venueNames\":{\"PLEYEL_PLEYEL\":\"Salle Pleyel\"}}";
+
+    /* with the 4-space indentation of the original */
+    return indentJson(out, 4);
+}
+#endif
@@ -0,0 +1,93 @@
+#ifndef _H_GENERATOR
+#define _H_GENERATOR /* guard */
+
+#include <string> /* std::string */
+#include <cstdint> /* uint64_t */
+#include <cstddef> /* size_t */
+
+/* xorshift64*, the same sequence on every platform and standard library */
+class Random
+{
+private:
+    uint64_t m_state;
+
+public:
+    // Constructor;
+    Random(uint64_t seed);
+
+    uint64_t next(void);
+    /* in [0, bound) */
+    unsigned int below(unsigned int bound);
+    /* in [min, max] */
+    unsigned int between(unsigned int min, unsigned int max);
+    /* in [0, 1) */
+    double unit(void);
+    const char* pick(const char* const* words, size_t count);
+};
+
+/* shape of generated documents, ranges are inclusive */
+typedef struct
+{
+    unsigned int maxDepth; /* containers nested at most this deep, the root is level 1 */
+    unsigned int minWidth, maxWidth; /* members per object */
+    unsigned int minLength, maxLength; /* elements per array */
+    unsigned int minString, maxString; /* characters per string value, short ones are more frequent */
+    unsigned int minKey, maxKey; /* characters per member key */
+    double escapes; /* share of string characters written as \n, \" and the like */
+    double unicode; /* share written as \uXXXX, a quarter of them surrogate pairs */
+    double utf8; /* share written as raw 2 to 4-byte UTF-8 */
+    double containers; /* share of values below maxDepth that are arrays or objects */
+    double objects; /* share of those containers that are objects */
+    /* relative weights of scalar kinds */
+    unsigned int strings;
+    unsigned int integers; /* up to 19 digits, small ones more frequent */
+    unsigned int decimals; /* fixed point with up to 17 fraction digits */
+    unsigned int exponents; /* 1.5e-300 and the like */
+    unsigned int literals; /* true, false and null */
+    /* 0 for a single tree from a root container,
+     * otherwise a root array growing until the text reaches about this many bytes */
+    size_t size;
+} GenShape;
+
+/* mixed documents resembling API traffic */
+void defaultShape(GenShape& shape);
+/* "64", "512K", "32M" or "1G", false on anything else */
+bool parseByteSize(const char* text, size_t& size);
+
+/* writes random but reproducible JSON text of a given shape,
+ * the same seed and shape give the same bytes */
+class Generator
+{
+private:
+    GenShape m_shape;
+    Random m_random;
+    size_t m_limit; /* containers stop growing once the output is this long */
+
+    void value(std::string& out, unsigned int level);
+    void array(std::string& out, unsigned int level);
+    void object(std::string& out, unsigned int level);
+    void string(std::string& out, unsigned int minLen, unsigned int maxLen);
+    void number(std::string& out, unsigned int kind);
+    void digits(std::string& out, unsigned int count, bool leading);
+    bool full(const std::string& out) const;
+
+public:
+    // Constructor;
+    Generator(const GenShape& shape, uint64_t seed);
+
+    // get-Functions;
+    const GenShape& getShape(void) const;
+
+    /* appends one document, without a trailing line break */
+    void generate(std::string& out);
+};
+
+/* documents shaped like the usual benchmark files twitter.json, canada.json and citm_catalog.json, 
+ * the same bytes on every run */
+std::string makeTwitter(void);
+std::string makeCanada(void);
+std::string makeCitm(void);
+/* compact json indented with width spaces, one element per line as Lept::Format(' ', width) prints it */
+std::string indentJson(const std::string& json, unsigned int width);
+
+#endif
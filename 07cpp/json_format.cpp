@@ -0,0 +1,1082 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono> /* std::chrono::steady_clock */
+#include <string>
+#include <vector>
+#include <algorithm> /* std::sort(), std::max() */
+#include <atomic> /* std::atomic<> */
+#include <thread> /* std::thread */
+#include <mutex> /* std::mutex, std::unique_lock<> */
+#include <condition_variable> /* std::condition_variable */
+#include "leptjson.h"
+#include "loader.h"
+#include <sys/stat.h> /* stat(), fstat() */
+#ifdef _WIN32
+#include <io.h> /* _fileno() */
+#define fileno _fileno
+#else
+#include <fcntl.h> /* open() */
+#include <unistd.h> /* read(), close(), sysconf() */
+#include <sys/mman.h> /* mmap(), munmap() */
+#include <dirent.h> /* opendir(), readdir() */
+#endif
+
+/* smaller files are copied into the reused buffer of Input, mapping them costs more */
+#define INPUT_MAP_MIN_SIZE (1 << 20)
+/* bytes requested per fread() */
+#define INPUT_READ_CHUNK 65536
+/* smallest piece of --lines input handed to a worker */
+#define LINES_MIN_CHUNK 65536
+
+/* command line options */
+typedef struct
+{
+    const char* input; /* nullptr for stdin */
+    std::vector<const char*> inputs; /* several, or a directory, mean batch mode */
+    const char* output; /* nullptr for stdout */
+    char indentChar;
+    unsigned int indentWidth;
+    Lept::Newline newline;
+    unsigned int width; /* maximum line width, 0 for one element per line */
+    unsigned int threads;
+    bool stats;
+    bool stream; /* reformat token by token without building the tree */
+    bool check; /* report unformatted files instead of writing output */
+    bool inPlace; /* replace each input with its formatted form */
+    bool lines; /* input holds several documents, one per line in the output */
+    bool uring; /* read batch inputs through io_uring where available */
+    bool minify; /* strip whitespace from the text without building the tree */
+    bool validate; /* check the syntax while minifying */
+    bool canonical; /* RFC 8785 form: sorted keys, shortest numbers, no whitespace */
+} Options;
+
+/* NUL-terminated input text, memory-mapped when large, 
+ * the buffer of small files is kept from one load() to the next */
+class Input
+{
+private:
+    const char* m_txt;
+    size_t m_size;
+    size_t m_mapped; /* length of the mapping, 0 if m_buffer holds the text */
+    std::vector<char> m_buffer;
+
+public:
+    // Constructor;
+    Input(void) :
+        m_txt(nullptr),
+        m_size(0),
+        m_mapped(0)
+    {
+
+    }
+    // Destructor;
+    ~Input(void)
+    {
+        this->release();
+    }
+
+    // get-Functions;
+    const char* getTxt(void) const
+    {
+        return this->m_txt;
+    }
+    size_t getSize(void) const
+    {
+        return this->m_size;
+    }
+    bool isMapped(void) const
+    {
+        return (this->m_mapped != 0);
+    }
+
+    /* load path, or stdin for nullptr; false on failure */
+    bool load(const char* path)
+    {
+        this->release();
+        FILE* fp = stdin;
+        if (path != nullptr && (fp = fopen(path, "rb")) == nullptr)
+            return false;
+
+        bool ret = this->map(fileno(fp)) || this->read(fp);
+        if (fp != stdin)
+            fclose(fp);
+
+        return ret;
+    }
+
+private:
+    void release(void)
+    {
+#ifndef _WIN32
+        if (this->m_mapped != 0)
+            munmap((void*)this->m_txt, this->m_mapped);
+#endif
+        this->m_txt = nullptr;
+        this->m_size = 0;
+        this->m_mapped = 0;
+
+        return;
+    }
+    /* large regular files whose size is not a multiple of the page size are mapped,
+     * the rest of the last page reads as zero and terminates the text for free */
+    bool map(int fd)
+    {
+#ifdef _WIN32
+        (void)fd;
+        return false;
+#else
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+            return false;
+
+        size_t size = (size_t)st.st_size;
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        if (size < INPUT_MAP_MIN_SIZE || size % page == 0)
+            return false;
+
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+            return false;
+        madvise(addr, size, MADV_SEQUENTIAL);
+
+        this->m_txt = (const char*)addr;
+        this->m_size = size;
+        this->m_mapped = size;
+        return true;
+#endif
+    }
+    bool read(FILE* fp)
+    {
+        size_t size = 0, len;
+
+        do
+        { /* read straight into the buffer, which only grows */
+            if (this->m_buffer.size() < size + INPUT_READ_CHUNK + 1)
+                this->m_buffer.resize(std::max(size + INPUT_READ_CHUNK + 1, this->m_buffer.size() * 2));
+            len = fread(&this->m_buffer[size], 1, INPUT_READ_CHUNK, fp);
+            size += len;
+        } while (len != 0);
+        if (ferror(fp))
+            return false;
+
+        this->m_buffer[size] = '\0';
+        this->m_size = size;
+        this->m_txt = this->m_buffer.data();
+        return true;
+    }
+};
+
+static const char* parseError(int ret)
+{
+    switch (ret)
+    {
+    case Lept::PARSE_EXPECT_VALUE: return "expect value";
+    case Lept::PARSE_INVALID_VALUE: return "invalid value";
+    case Lept::PARSE_ROOT_NOT_SINGULAR: return "root not singular";
+    case Lept::PARSE_NUMBER_OVERFLOW: return "number overflow";
+    case Lept::PARSE_MISSING_QUOTATION_MARK: return "missing quotation mark";
+    case Lept::PARSE_INVALID_STRING_ESCAPE: return "invalid string escape";
+    case Lept::PARSE_INVALID_STRING_CHAR: return "invalid string char";
+    case Lept::PARSE_INVALID_UNICODE_HEX: return "invalid unicode hex";
+    case Lept::PARSE_INVALID_UNICODE_SURROGATE: return "invalid unicode surrogate";
+    case Lept::PARSE_MISSING_COMMA_OR_BRACKET: return "missing comma or bracket";
+    case Lept::PARSE_MISSING_KEY: return "missing key";
+    case Lept::PARSE_MISSING_COLON: return "missing colon";
+    case Lept::PARSE_MISSING_COMMA_OR_BRACE: return "missing comma or brace";
+    case Lept::PARSE_HANDLER_ABORTED: return "output failed";
+    default: return "unknown error";
+    }
+}
+
+static const char* stringifyError(int ret)
+{
+    switch (ret)
+    {
+    case Lept::STRINGIFY_FILE_OPEN_FAILURE: return "cannot open output";
+    case Lept::STRINGIFY_FILE_WRITE_FAILURE: return "cannot write output";
+    case Lept::STRINGIFY_NOT_FINITE: return "number out of range for --canonical";
+    default: return "unknown error";
+    }
+}
+
+/* line and column, both from 1, of pos in txt */
+static void locate(const char* txt, const char* pos, unsigned long& line, unsigned long& column)
+{
+    line = 1;
+    column = 1;
+    for (const char* p = txt; p < pos; ++p)
+    {
+        if (*p == '\n')
+        {
+            ++line;
+            column = 1;
+        }
+        else
+            ++column;
+    }
+
+    return;
+}
+
+static double elapsed(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+static void usage(FILE* fp)
+{
+    fprintf(fp,
+        "usage: json-format [options] [input...]\n"
+        "  input               JSON file, stdin when omitted or \"-\",\n"
+        "                      several files or directories (searched for *.json, without following links\n"
+        "                      to directories) are formatted in a batch\n"
+        "  -o, --output FILE   write to FILE instead of stdout\n"
+        "  -c, --compact       no line breaks or indentation\n"
+        "  -m, --minify        strip whitespace without parsing into a tree, faster than -c,\n"
+        "                      numbers and escapes stay as written\n"
+        "      --no-validate   with --minify, skip the syntax check, invalid input is stripped as is\n"
+        "      --canonical     RFC 8785 canonical form for hashing and signing: compact,\n"
+        "                      members sorted by key, shortest numbers, minimal escapes\n"
+        "      --indent N      indent with N spaces instead of a tab\n"
+        "      --tab           indent with a tab (default)\n"
+        "      --crlf          CRLF line breaks\n"
+        "  -w, --width N       keep containers on one line when they fit in N columns\n"
+        "  -j, --threads N     stringify large root containers on N threads,\n"
+        "                      format N files at a time in a batch (default: one per core),\n"
+        "                      split --lines input across N workers, documents must not span lines\n"
+        "      --stream        reformat in constant memory without building the tree\n"
+        "  -l, --lines         input holds any number of documents (NDJSON), each is written\n"
+        "                      on its own line(s), broken lines are reported and skipped\n"
+        "      --check         list files that are not formatted on stdout, write nothing\n"
+        "  -i, --in-place      replace inputs that are not formatted, leave the others untouched\n"
+        "      --no-io-uring   read batch inputs with blocking calls instead of io_uring\n"
+        "      --stats         report sizes and timings on stderr, allocations by phase in builds\n"
+        "                      configured with -DLEPT_ALLOC_STATS=ON, and what the parser met in\n"
+        "                      the text in builds configured with -DLEPT_CONTEXT_STATS=ON\n"
+        "  -h, --help          show this help\n");
+
+    return;
+}
+
+/* return false on invalid command line */
+static bool parseOptions(int argc, char* argv[], Options& opt)
+{
+    opt.input = nullptr;
+    opt.output = nullptr;
+    opt.indentChar = '\t';
+    opt.indentWidth = 1;
+    opt.newline = Lept::Newline::LF;
+    opt.width = 0;
+    opt.threads = 0; /* 1 for a single file, one per core for a batch */
+    opt.stats = false;
+    opt.stream = false;
+    opt.check = false;
+    opt.inPlace = false;
+    opt.lines = false;
+    opt.uring = true;
+    opt.minify = false;
+    opt.validate = true;
+    opt.canonical = false;
+
+    for (int index = 1; index < argc; ++index)
+    {
+        const char* arg = argv[index];
+        bool hasNext = (index + 1 < argc);
+
+        if (!strcmp(arg, "-o") || !strcmp(arg, "--output"))
+        {
+            if (!hasNext)
+                return false;
+            opt.output = argv[++index];
+        }
+        else if (!strcmp(arg, "-c") || !strcmp(arg, "--compact"))
+            opt.newline = Lept::Newline::NONE;
+        else if (!strcmp(arg, "--indent"))
+        {
+            if (!hasNext)
+                return false;
+            opt.indentChar = ' ';
+            opt.indentWidth = (unsigned int)atoi(argv[++index]);
+        }
+        else if (!strcmp(arg, "--tab"))
+        {
+            opt.indentChar = '\t';
+            opt.indentWidth = 1;
+        }
+        else if (!strcmp(arg, "--crlf"))
+            opt.newline = Lept::Newline::CRLF;
+        else if (!strcmp(arg, "-w") || !strcmp(arg, "--width"))
+        {
+            if (!hasNext)
+                return false;
+            opt.width = (unsigned int)atoi(argv[++index]);
+        }
+        else if (!strcmp(arg, "-j") || !strcmp(arg, "--threads"))
+        {
+            if (!hasNext)
+                return false;
+            opt.threads = (unsigned int)atoi(argv[++index]);
+        }
+        else if (!strcmp(arg, "--stats"))
+            opt.stats = true;
+        else if (!strcmp(arg, "--stream"))
+            opt.stream = true;
+        else if (!strcmp(arg, "--check"))
+            opt.check = true;
+        else if (!strcmp(arg, "-i") || !strcmp(arg, "--in-place"))
+            opt.inPlace = true;
+        else if (!strcmp(arg, "-l") || !strcmp(arg, "--lines"))
+            opt.lines = true;
+        else if (!strcmp(arg, "--no-io-uring"))
+            opt.uring = false;
+        else if (!strcmp(arg, "-m") || !strcmp(arg, "--minify"))
+            opt.minify = true;
+        else if (!strcmp(arg, "--no-validate"))
+            opt.validate = false;
+        else if (!strcmp(arg, "--canonical"))
+            opt.canonical = true;
+        else if (!strcmp(arg, "-"))
+            opt.inputs.push_back(nullptr);
+        else if (arg[0] == '-')
+            return false;
+        else
+            opt.inputs.push_back(arg);
+    }
+    opt.input = opt.inputs.empty() ? nullptr : opt.inputs[0];
+
+    /* stdin cannot be part of a batch or be replaced */
+    bool hasStdin = opt.inputs.empty() || std::find(opt.inputs.begin(), opt.inputs.end(), nullptr) != opt.inputs.end();
+    if (opt.inputs.size() > 1 && hasStdin)
+        return false;
+    if (opt.inPlace && (hasStdin || opt.output != nullptr || opt.check))
+        return false;
+    if (opt.lines && (opt.inputs.size() > 1 || opt.check || opt.stream))
+        return false;
+    if (opt.minify && (opt.lines || opt.stream))
+        return false;
+    if (opt.canonical && (opt.minify || opt.stream))
+        return false;
+    if (opt.width != 0 && opt.stream) /* the width needs the tree */
+        return false;
+    if (opt.minify || opt.canonical) /* output has no line breaks, not even a final one */
+        opt.newline = Lept::Newline::NONE;
+
+    return true;
+}
+
+/* whether both paths name one file, false if either does not exist */
+static bool isSameFile(const char* path, const char* other)
+{
+#ifdef _WIN32
+    char full[_MAX_PATH], fullOther[_MAX_PATH];
+    return _fullpath(full, path, sizeof(full)) != nullptr && _fullpath(fullOther, other, sizeof(fullOther)) != nullptr
+        && _stricmp(full, fullOther) == 0;
+#else
+    struct stat st, stOther;
+    return stat(path, &st) == 0 && stat(other, &stOther) == 0 && st.st_dev == stOther.st_dev && st.st_ino == stOther.st_ino;
+#endif
+}
+
+static Lept::Writer* openOutput(const Options& opt, const Lept::Format& fmt)
+{
+    if (opt.inPlace)
+        return new Lept::ReplaceWriter(opt.input, fmt);
+    else if (opt.output != nullptr && opt.input != nullptr && isSameFile(opt.input, opt.output))
+        return new Lept::ReplaceWriter(opt.output, fmt); /* the input is still being read, it is replaced once written */
+    else if (opt.output != nullptr)
+        return new Lept::FileWriter(opt.output, fmt);
+    else
+        return new Lept::FdWriter(fileno(stdout), fmt);
+}
+
+/* close output after an error: a file being replaced keeps its contents, 
+ * a partly written -o file is removed */
+static void discardOutput(const Options& opt, Lept::Writer* out)
+{
+    bool partial = (opt.output != nullptr && dynamic_cast<Lept::ReplaceWriter*>(out) == nullptr
+        && out->getStatus() != Lept::STRINGIFY_FILE_OPEN_FAILURE);
+    delete out;
+    if (partial)
+        remove(opt.output);
+
+    return;
+}
+
+/* end the last line, flush and close output, return exit code */
+static int closeOutput(const Options& opt, Lept::Writer* out, int ret)
+{
+    const Lept::Format& fmt = out->getFormat();
+    if (ret == Lept::STRINGIFY_OK && !fmt.isCompact() && !opt.lines)
+        out->endLine();
+    Lept::ReplaceWriter* replace = dynamic_cast<Lept::ReplaceWriter*>(out);
+    if (ret == Lept::STRINGIFY_OK)
+        ret = (replace != nullptr) ? replace->commit() : out->flush();
+    if (ret != Lept::STRINGIFY_OK)
+    {
+        discardOutput(opt, out);
+        const char* target = opt.inPlace ? opt.input : (opt.output != nullptr) ? opt.output : "<stdout>";
+        fprintf(stderr, "json-format: %s: %s\n", target, stringifyError(ret));
+        return 1;
+    }
+    delete out;
+
+    return 0;
+}
+
+static int stringify(const Options& opt, const Lept::Value& v, Lept::Writer& w)
+{
+    return opt.canonical ? v.stringifyCanonical(w) : v.stringify(w);
+}
+
+/* --stream: feed the input chunk by chunk to a Reader driving a Reformatter, 
+ * memory stays bounded by nesting depth and the longest string whatever the input size */
+static int stream(const Options& opt, const char* name)
+{
+    FILE* fp = stdin;
+    if (opt.input != nullptr && (fp = fopen(opt.input, "rb")) == nullptr)
+    {
+        fprintf(stderr, "json-format: %s: cannot read input\n", name);
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    Lept::Writer* out = openOutput(opt, fmt);
+    Lept::Reformatter handler(*out);
+    Lept::Reader reader(handler);
+
+    static char chunk[65536];
+    unsigned long line = 1, column = 1;
+    size_t len;
+    int ret = out->getStatus();
+    while (ret == Lept::STRINGIFY_OK && (len = fread(chunk, 1, sizeof(chunk), fp)) != 0)
+    {
+        size_t before = reader.getOffset();
+        int status = reader.feed(chunk, len);
+        for (const char* p = chunk; p < chunk + (reader.getOffset() - before); ++p)
+        { /* track the position for error messages */
+            if (*p == '\n')
+            {
+                ++line;
+                column = 1;
+            }
+            else
+                ++column;
+        }
+        if (status != Lept::PARSE_OK)
+            break;
+    }
+    bool readFailed = (ferror(fp) != 0);
+    if (fp != stdin)
+        fclose(fp);
+
+    int status = (ret == Lept::STRINGIFY_OK && !readFailed) ? reader.finish() : reader.getStatus();
+    if (ret == Lept::STRINGIFY_OK)
+        ret = out->getStatus();
+    if (readFailed)
+    {
+        discardOutput(opt, out);
+        fprintf(stderr, "json-format: %s: cannot read input\n", name);
+        return 1;
+    }
+    if (status != Lept::PARSE_OK && ret == Lept::STRINGIFY_OK)
+    {
+        discardOutput(opt, out);
+        fprintf(stderr, "json-format: %s:%lu:%lu: %s\n", name, line, column, parseError(status));
+        return 1;
+    }
+    if (closeOutput(opt, out, ret) != 0)
+        return 1;
+
+    if (opt.stats)
+    {
+        double total = elapsed(t0, std::chrono::steady_clock::now());
+        fprintf(stderr, "input:     %zu bytes (streamed)\n", reader.getOffset());
+        fprintf(stderr, "total:     %10.3f ms  %8.1f MB/s\n", total * 1e3, reader.getOffset() / 1e6 / total);
+    }
+
+    return 0;
+}
+
+/* --minify: strip the whitespace of the whole text in one pass, no tree is built */
+static int minify(const Options& opt, const char* name)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    Input in;
+    if (!in.load(opt.input))
+    {
+        fprintf(stderr, "json-format: %s: cannot read input\n", name);
+        return 1;
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    Lept::Writer* out = openOutput(opt, fmt);
+    Lept::Minifier minifier(*out, opt.validate);
+    int ret = out->getStatus();
+    int status = Lept::PARSE_OK;
+    if (ret == Lept::STRINGIFY_OK && (status = minifier.feed(in.getTxt(), in.getSize())) == Lept::PARSE_OK)
+        status = minifier.finish();
+    if (ret == Lept::STRINGIFY_OK)
+        ret = out->getStatus();
+    if (status != Lept::PARSE_OK && ret == Lept::STRINGIFY_OK)
+    {
+        discardOutput(opt, out);
+        unsigned long line, column;
+        locate(in.getTxt(), in.getTxt() + minifier.getOffset(), line, column);
+        fprintf(stderr, "json-format: %s:%lu:%lu: %s\n", name, line, column, parseError(status));
+        return 1;
+    }
+    if (closeOutput(opt, out, ret) != 0)
+        return 1;
+
+    if (opt.stats)
+    {
+        double load = elapsed(t0, t1), total = elapsed(t0, std::chrono::steady_clock::now());
+        fprintf(stderr, "input:     %zu bytes (%s)\n", in.getSize(), in.isMapped() ? "mapped" : "read");
+        fprintf(stderr, "load:      %10.3f ms\n", load * 1e3);
+        fprintf(stderr, "minify:    %10.3f ms  %8.1f MB/s%s\n", (total - load) * 1e3, in.getSize() / 1e6 / (total - load), opt.validate ? "" : " (not validated)");
+    }
+
+    return 0;
+}
+
+/* state shared by the workers of --lines -j N */
+class LineJobs
+{
+public:
+    const Options* opt;
+    const char* name;
+    const char* txt;
+    std::vector<size_t> bounds; /* chunk index covers [bounds[index], bounds[index + 1]) of txt */
+    std::atomic<size_t> next; /* next chunk to take */
+    std::atomic<size_t> count; /* documents written */
+    std::atomic<size_t> failed; /* documents with errors */
+    Lept::Writer* out;
+    std::mutex mutex;
+    std::condition_variable turn;
+    size_t written; /* chunks done writing, output follows input order */
+    unsigned long line; /* lines before the next chunk to write, for error positions */
+
+    LineJobs(const Options& options, const char* inputName, const char* text, Lept::Writer* output) :
+        opt(&options),
+        name(inputName),
+        txt(text),
+        next(0),
+        count(0),
+        failed(0),
+        out(output),
+        written(0),
+        line(0)
+    {
+
+    }
+};
+
+/* worker of --lines -j N, owns the copy of its chunk, its output and its Value */
+static void formatChunks(LineJobs& j)
+{
+    const Options& opt = *j.opt;
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    std::vector<char> text;
+    std::string buffer;
+    std::vector<const std::string*> chunks(1, &buffer);
+    std::vector<std::pair<size_t, int> > errors; /* offset in chunk and status */
+    Lept::Value v;
+    size_t index;
+
+    while ((index = j.next++) + 1 < j.bounds.size())
+    {
+        /* DocumentStream needs the chunk NUL-terminated */
+        text.assign(j.txt + j.bounds[index], j.txt + j.bounds[index + 1]);
+        text.push_back('\0');
+        buffer.clear();
+        errors.clear();
+        {
+            Lept::StringWriter w(buffer, fmt);
+            Lept::DocumentStream ds(text.data());
+            for (;;)
+            {
+                if (ds.next(v))
+                {
+                    ++j.count;
+                    stringify(opt, v, w);
+                    w.endLine();
+                    continue;
+                }
+                if (ds.getStatus() == Lept::PARSE_OK)
+                    break;
+                errors.push_back(std::make_pair(ds.getEnd(), ds.getStatus()));
+                if (!ds.resync())
+                    break;
+            }
+        }
+        unsigned long newlines = (unsigned long)std::count(text.begin(), text.end(), '\n');
+
+        std::unique_lock<std::mutex> lock(j.mutex);
+        j.turn.wait(lock, [&j, index]() { return j.written == index; });
+        j.out->writeChunks(chunks);
+        for (const std::pair<size_t, int>& error : errors)
+        {
+            unsigned long line, column;
+            locate(text.data(), text.data() + error.first, line, column);
+            fprintf(stderr, "json-format: %s:%lu:%lu: %s\n", j.name, j.line + line, column, parseError(error.second));
+        }
+        j.failed += errors.size();
+        j.line += newlines;
+        ++j.written;
+        lock.unlock();
+        j.turn.notify_all();
+    }
+
+    return;
+}
+
+/* --lines: every document of the input in turn, each ends its line even when compact */
+static int lines(const Options& opt, const char* name)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    Input in;
+    if (!in.load(opt.input))
+    {
+        fprintf(stderr, "json-format: %s: cannot read input\n", name);
+        return 1;
+    }
+
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    Lept::Writer* out = openOutput(opt, fmt);
+    Lept::DocumentStream ds(in.getTxt());
+    Lept::Value v;
+    size_t count = 0, failed = 0;
+    int ret = out->getStatus();
+    if (opt.threads > 1 && ret == Lept::STRINGIFY_OK)
+    {
+        /* cut the input after a newline every chunkSize bytes or so */
+        LineJobs j(opt, name, in.getTxt(), out);
+        size_t size = in.getSize();
+        size_t chunkSize = std::max<size_t>(LINES_MIN_CHUNK, size / ((size_t)opt.threads * 8));
+        j.bounds.push_back(0);
+        while (j.bounds.back() < size)
+        {
+            size_t end = j.bounds.back() + chunkSize;
+            const char* newline = (end < size) ? (const char*)memchr(in.getTxt() + end, '\n', size - end) : nullptr;
+            j.bounds.push_back((newline != nullptr) ? (size_t)(newline - in.getTxt()) + 1 : size);
+        }
+
+        std::vector<std::thread> workers;
+        for (unsigned int index = 1; index < opt.threads; ++index)
+            workers.emplace_back(formatChunks, std::ref(j));
+        formatChunks(j);
+        for (std::thread& worker : workers)
+            worker.join();
+        count = j.count;
+        failed = j.failed;
+        ret = out->getStatus();
+    }
+    while (opt.threads <= 1 && ret == Lept::STRINGIFY_OK)
+    {
+        if (ds.next(v))
+        {
+            ++count;
+            ret = stringify(opt, v, *out);
+            out->endLine();
+            continue;
+        }
+        if (ds.getStatus() == Lept::PARSE_OK)
+            break;
+
+        unsigned long line, column;
+        locate(in.getTxt(), in.getTxt() + ds.getEnd(), line, column);
+        fprintf(stderr, "json-format: %s:%lu:%lu: %s\n", name, line, column, parseError(ds.getStatus()));
+        ++failed;
+        if (!ds.resync())
+            break;
+    }
+    if (failed != 0 && dynamic_cast<Lept::ReplaceWriter*>(out) != nullptr)
+    {
+        discardOutput(opt, out); /* keep the original, -i or -o naming the input */
+        return 1;
+    }
+    if (closeOutput(opt, out, ret) != 0)
+        return 1;
+
+    if (opt.stats)
+    {
+        double total = elapsed(t0, std::chrono::steady_clock::now());
+        fprintf(stderr, "documents: %zu (%zu failed)\n", count, failed);
+        fprintf(stderr, "input:     %zu bytes (%s)\n", in.getSize(), in.isMapped() ? "mapped" : "read");
+        fprintf(stderr, "total:     %10.3f ms  %8.1f MB/s\n", total * 1e3, in.getSize() / 1e6 / total);
+    }
+
+    return (failed != 0) ? 1 : 0;
+}
+
+static bool isDirectory(const char* path)
+{
+    struct stat st;
+
+    return (path != nullptr && stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR);
+}
+
+/* append path to files, or the *.json files below it in name order if it is a directory, 
+ * symbolic links to directories below it are not followed, they may lead back up */
+static void collect(const std::string& path, std::vector<std::string>& files)
+{
+#ifndef _WIN32
+    DIR* dir = isDirectory(path.c_str()) ? opendir(path.c_str()) : nullptr;
+    if (dir != nullptr)
+    {
+        std::vector<std::string> names;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr)
+        {
+            if (entry->d_name[0] != '.') /* ., .. and hidden entries */
+                names.push_back(entry->d_name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+
+        for (const std::string& name : names)
+        {
+            std::string child = path + '/' + name;
+            bool isJson = (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0);
+            struct stat st;
+            if (isDirectory(child.c_str()))
+            {
+                if (lstat(child.c_str(), &st) == 0 && (st.st_mode & S_IFMT) != S_IFLNK)
+                    collect(child, files);
+            }
+            else if (isJson)
+                files.push_back(child);
+        }
+        return;
+    }
+#endif
+    files.push_back(path); /* files and unreadable paths, which fail when loaded */
+
+    return;
+}
+
+/* state shared by the workers of a batch */
+class Batch
+{
+public:
+    const Options* opt;
+    std::vector<std::string> files;
+    std::vector<std::string> messages; /* errors per file, --check and --in-place print them in order at the end */
+    std::vector<char> unformatted; /* per file, set by --check */
+    Loader* loader; /* reads files ahead of the workers */
+    std::atomic<size_t> bytes; /* input bytes loaded */
+    std::atomic<size_t> failed; /* files with errors or, under --check, not formatted */
+    std::atomic<size_t> replaced; /* files rewritten by --in-place */
+    Lept::Writer* out; /* nullptr under --check and --in-place */
+    std::mutex mutex;
+    std::condition_variable turn;
+    size_t written; /* files done writing, output follows argument order */
+
+    Batch(const Options& options) :
+        opt(&options),
+        loader(nullptr),
+        bytes(0),
+        failed(0),
+        replaced(0),
+        out(nullptr),
+        written(0)
+    {
+
+    }
+};
+
+/* parse the text loaded from path and stringify it into buffer, return an error message or "" */
+static std::string formatFile(const Options& opt, const char* path, const char* txt, size_t size, std::string& buffer, const Lept::Format& fmt)
+{
+    if (!strcmp(path, "-"))
+        path = "<stdin>";
+    if (txt == nullptr)
+        return std::string("json-format: ") + path + ": cannot read input\n";
+
+    if (opt.minify)
+    {
+        buffer.clear();
+        Lept::StringWriter w(buffer, fmt);
+        Lept::Minifier minifier(w, opt.validate);
+        int ret = minifier.feed(txt, size);
+        if (ret == Lept::PARSE_OK)
+            ret = minifier.finish();
+        if (ret == Lept::PARSE_OK)
+            return std::string();
+        unsigned long line, column;
+        locate(txt, txt + minifier.getOffset(), line, column);
+        return std::string("json-format: ") + path + ":" + std::to_string(line) + ":" + std::to_string(column) + ": " + parseError(ret) + "\n";
+    }
+
+    Lept::Value v;
+    Lept::Context c(txt);
+    int ret = v.parse(c);
+    if (ret != Lept::PARSE_OK)
+    {
+        unsigned long line, column;
+        locate(txt, c.getTxt(), line, column);
+        return std::string("json-format: ") + path + ":" + std::to_string(line) + ":" + std::to_string(column) + ": " + parseError(ret) + "\n";
+    }
+
+    buffer.clear(); /* keeps its capacity for the next file */
+    {
+        Lept::StringWriter w(buffer, fmt);
+        stringify(opt, v, w);
+    }
+    if (!fmt.isCompact())
+        buffer.append((fmt.getNewline() == Lept::Newline::CRLF) ? "\r\n" : "\n");
+
+    return std::string();
+}
+
+/* worker of a batch, takes files as the loader completes them, 
+ * the output buffer lives as long as the worker */
+static void formatFiles(Batch& b)
+{
+    const Options& opt = *b.opt;
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    std::string buffer;
+    LoadBuffer* in;
+
+    while ((in = b.loader->next()) != nullptr)
+    {
+        size_t index = in->index;
+        const char* path = b.files[index].c_str();
+        const char* txt = (in->error == 0) ? in->data.data() : nullptr;
+        std::string message = formatFile(opt, path, txt, in->size, buffer, fmt);
+        b.bytes += in->size;
+        if (!message.empty())
+            ++b.failed;
+
+        bool same = message.empty() && buffer.size() == in->size && memcmp(buffer.data(), txt, buffer.size()) == 0;
+        b.loader->release(in); /* lets the loader read ahead while this file is written */
+        if (opt.check)
+        {
+            b.messages[index] = message;
+            if (message.empty() && !same)
+            {
+                b.unformatted[index] = 1;
+                ++b.failed;
+            }
+            continue;
+        }
+        if (opt.inPlace)
+        {
+            if (message.empty() && !same)
+            {
+                Lept::ReplaceWriter w(path, fmt);
+                w.write(buffer.data(), buffer.size());
+                int ret = w.commit();
+                if (ret != Lept::STRINGIFY_OK)
+                {
+                    message = std::string("json-format: ") + path + ": " + stringifyError(ret) + "\n";
+                    ++b.failed;
+                }
+                else if (w.isChanged())
+                    ++b.replaced;
+            }
+            b.messages[index] = message;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(b.mutex);
+        b.turn.wait(lock, [&b, index]() { return b.written == index; });
+        if (!message.empty())
+            fputs(message.c_str(), stderr);
+        else
+            b.out->write(buffer.data(), buffer.size());
+        ++b.written;
+        lock.unlock();
+        b.turn.notify_all();
+    }
+
+    return;
+}
+
+/* several inputs or a directory: format every file on a pool of workers, 
+ * fed by a Loader keeping many reads in flight, 
+ * an error stops the file it occurs in but not the batch */
+static int batch(const Options& opt)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    Batch b(opt);
+    for (const char* input : opt.inputs)
+        collect((input != nullptr) ? input : "-", b.files);
+    if (opt.inputs.empty())
+        b.files.push_back("-");
+    b.messages.resize(b.files.size());
+    b.unformatted.resize(b.files.size(), 0);
+
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    if (!opt.check && !opt.inPlace)
+    {
+        for (const std::string& file : b.files)
+        {
+            if (opt.output != nullptr && isSameFile(file.c_str(), opt.output))
+            {
+                fprintf(stderr, "json-format: %s: output is also an input\n", opt.output);
+                return 1;
+            }
+        }
+        b.out = openOutput(opt, fmt);
+        if (b.out->getStatus() != Lept::STRINGIFY_OK)
+            return closeOutput(opt, b.out, b.out->getStatus());
+    }
+
+    unsigned int threads = (opt.threads != 0) ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned int)std::min<size_t>(threads, std::max<size_t>(1, b.files.size()));
+    /* output follows argument order, so files are handed out in that order too, 
+     * otherwise in the order their reads complete */
+    Loader loader(b.files, !opt.check && !opt.inPlace, threads, opt.uring);
+    b.loader = &loader;
+    std::vector<std::thread> workers;
+    for (unsigned int index = 1; index < threads; ++index)
+        workers.emplace_back(formatFiles, std::ref(b));
+    formatFiles(b);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    int ret = 0;
+    for (size_t index = 0; index < b.files.size(); ++index)
+    {
+        fputs(b.messages[index].c_str(), stderr);
+        if (b.unformatted[index])
+            printf("%s\n", (b.files[index] == "-") ? "<stdin>" : b.files[index].c_str());
+    }
+    if (b.out != nullptr)
+        ret = closeOutput(opt, b.out, b.out->getStatus());
+    if (b.failed != 0)
+        ret = 1;
+
+    if (opt.stats)
+    {
+        double total = elapsed(t0, std::chrono::steady_clock::now());
+        fprintf(stderr, "files:     %zu (%zu failed, %zu replaced) on %u threads\n", b.files.size(), (size_t)b.failed, (size_t)b.replaced, threads);
+        fprintf(stderr, "input:     %zu bytes\n", (size_t)b.bytes);
+        fprintf(stderr, "io:        %s\n", loader.isUring() ? "io_uring" : "blocking reads");
+        fprintf(stderr, "total:     %10.3f ms  %8.1f MB/s\n", total * 1e3, b.bytes / 1e6 / total);
+    }
+
+    return ret;
+}
+
+#ifdef LEPT_ALLOC_STATS
+/* allocations since the last Lept::resetAllocStats(), by the library call that made them */
+static void reportAllocs(void)
+{
+    const Lept::AllocPhase phases[] = { Lept::AllocPhase::PARSE, Lept::AllocPhase::STRINGIFY, Lept::AllocPhase::DESTROY, Lept::AllocPhase::OTHER };
+    const char* names[] = { "parse", "stringify", "destroy", "other" };
+    for (size_t index = 0; index < sizeof(phases) / sizeof(phases[0]); ++index)
+    {
+        Lept::AllocStats stats = Lept::getAllocStats(phases[index]);
+        fprintf(stderr, "%-10s %9zu allocs %12zu bytes %9zu frees %12zu bytes  peak %zu bytes\n", 
+            names[index], stats.allocs, stats.bytes, stats.frees, stats.freedBytes, stats.peak);
+    }
+
+    return;
+}
+#endif
+
+#ifdef LEPT_CONTEXT_STATS
+/* what the parser met in the text, and the cycles its hot paths took */
+static void reportContext(const Lept::ContextStats& stats)
+{
+    fprintf(stderr, "whitespace: %10zu bytes %14llu cycles\n", stats.wsBytes, stats.wsCycles);
+    fprintf(stderr, "strings:    %10zu bytes %14llu cycles  %zu escapes, %zu \\u\n", 
+        stats.stringBytes, stats.stringCycles, stats.escapes, stats.unicodeEscapes);
+    fprintf(stderr, "numbers:    %10zu bytes %14llu cycles\n", stats.numberBytes, stats.numberCycles);
+    fprintf(stderr, "literals:   %10zu bytes\n", stats.literalBytes);
+    fprintf(stderr, "depth:      %10u\n", stats.maxDepth);
+
+    return;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    for (int index = 1; index < argc; ++index)
+    {
+        if (!strcmp(argv[index], "-h") || !strcmp(argv[index], "--help"))
+        {
+            usage(stdout);
+            return 0;
+        }
+    }
+    if (!parseOptions(argc, argv, opt))
+    {
+        usage(stderr);
+        return 2;
+    }
+    if (opt.inputs.size() > 1 || opt.check || isDirectory(opt.input))
+        return batch(opt);
+    const char* name = (opt.input != nullptr) ? opt.input : "<stdin>";
+    if (opt.stream)
+        return stream(opt, name);
+    if (opt.lines)
+        return lines(opt, name);
+    if (opt.minify)
+        return minify(opt, name);
+
+    /* load */
+    if (opt.stats)
+        Lept::resetAllocStats();
+    auto t0 = std::chrono::steady_clock::now();
+    Input in;
+    if (!in.load(opt.input))
+    {
+        fprintf(stderr, "json-format: %s: cannot read input\n", name);
+        return 1;
+    }
+
+    /* parse */
+    auto t1 = std::chrono::steady_clock::now();
+    Lept::Value v;
+    Lept::Context c(in.getTxt());
+    int ret = v.parse(c);
+    if (ret != Lept::PARSE_OK)
+    {
+        unsigned long line, column;
+        locate(in.getTxt(), c.getTxt(), line, column);
+        fprintf(stderr, "json-format: %s:%lu:%lu: %s\n", name, line, column, parseError(ret));
+        return 1;
+    }
+
+    /* stringify */
+    auto t2 = std::chrono::steady_clock::now();
+    Lept::Format fmt(opt.indentChar, opt.indentWidth, opt.newline, opt.width);
+    Lept::Writer* out = openOutput(opt, fmt);
+    ret = out->getStatus();
+    if (ret == Lept::STRINGIFY_OK)
+        ret = opt.canonical ? v.stringifyCanonical(*out) : v.stringifyParallel(*out, opt.threads);
+    if (closeOutput(opt, out, ret) != 0)
+        return 1;
+    auto t3 = std::chrono::steady_clock::now();
+
+    if (opt.stats)
+    {
+        double load = elapsed(t0, t1), parse = elapsed(t1, t2), stringify = elapsed(t2, t3);
+        /* the canonical size is not known up front, its rate is measured on input */
+        size_t outSize = opt.canonical ? in.getSize() : v.stringifySize(fmt) + fmt.breakLineSize(0);
+        fprintf(stderr, "input:     %zu bytes (%s)\n", in.getSize(), in.isMapped() ? "mapped" : "read");
+        if (!opt.canonical)
+            fprintf(stderr, "output:    %zu bytes\n", outSize);
+        fprintf(stderr, "load:      %10.3f ms\n", load * 1e3);
+        fprintf(stderr, "parse:     %10.3f ms  %8.1f MB/s\n", parse * 1e3, in.getSize() / 1e6 / parse);
+        fprintf(stderr, "stringify: %10.3f ms  %8.1f MB/s\n", stringify * 1e3, outSize / 1e6 / stringify);
+        fprintf(stderr, "total:     %10.3f ms\n", elapsed(t0, t3) * 1e3);
+#ifdef LEPT_CONTEXT_STATS
+        reportContext(c.getStats());
+#endif
+#ifdef LEPT_ALLOC_STATS
+        v.setNull(); /* count the destruction of the tree too */
+        reportAllocs();
+#endif
+    }
+
+    return 0;
+}
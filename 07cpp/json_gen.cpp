@@ -0,0 +1,193 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "generator.h"
+
+/* text handed to fwrite() at once */
+#define GEN_WRITE_CHUNK (1 << 20)
+
+/* command line options */
+typedef struct
+{
+    const char* output; /* nullptr for stdout */
+    uint64_t seed;
+    unsigned int count; /* documents, one per line when more than one */
+    GenShape shape;
+} Options;
+
+static void usage(FILE* fp)
+{
+    fprintf(fp,
+        "usage: leptjson_gen [options]\n"
+        "  -o, --output FILE     write to FILE instead of stdout\n"
+        "  -s, --seed N          documents differ by seed and are the same for a seed (default: 1)\n"
+        "  -n, --count N         write N documents, one per line (NDJSON) (default: 1)\n"
+        "      --size BYTES      root array grown to about BYTES, K, M and G suffixes are allowed,\n"
+        "                        a single tree from a root container when omitted\n"
+        "      --depth N         containers nested at most N deep (default: 6)\n"
+        "      --width A[-B]     members per object (default: 1-8)\n"
+        "      --length A[-B]    elements per array (default: 0-16)\n"
+        "      --string A[-B]    characters per string value, short ones more frequent (default: 0-32)\n"
+        "      --key A[-B]       characters per member key (default: 1-12)\n"
+        "      --escapes RATE    share of string characters written as \\n, \\\" ... (default: 0.02)\n"
+        "      --unicode RATE    share written as \\uXXXX escapes (default: 0.01)\n"
+        "      --utf8 RATE       share written as raw multi-byte UTF-8 (default: 0.05)\n"
+        "      --containers RATE share of values that are arrays or objects (default: 0.3)\n"
+        "      --objects RATE    share of containers that are objects (default: 0.6)\n"
+        "      --kinds S:I:D:E:L relative weights of strings, integers, decimals, exponents\n"
+        "                        and literals among scalars (default: 4:3:2:1:1)\n"
+        "  -h, --help            show this help\n");
+
+    return;
+}
+
+/* "A" or "A-B" */
+static bool parseRange(const char* text, unsigned int& min, unsigned int& max)
+{
+    char* end;
+    min = max = (unsigned int)strtoul(text, &end, 10);
+    if (end == text)
+        return false;
+    if (*end == '-')
+    {
+        text = end + 1;
+        max = (unsigned int)strtoul(text, &end, 10);
+        if (end == text)
+            return false;
+    }
+
+    return *end == '\0' && min <= max;
+}
+
+static bool parseRate(const char* text, double& rate)
+{
+    char* end;
+    rate = strtod(text, &end);
+
+    return end != text && *end == '\0' && rate >= 0.0 && rate <= 1.0;
+}
+
+static bool parseKinds(const char* text, GenShape& shape)
+{
+    unsigned int* weights[] = { &shape.strings, &shape.integers, &shape.decimals, &shape.exponents, &shape.literals };
+    const size_t count = sizeof(weights) / sizeof(weights[0]);
+    char* end;
+    for (size_t index = 0; index < count; ++index)
+    {
+        char separator = (index + 1 < count) ? ':' : '\0';
+        *weights[index] = (unsigned int)strtoul(text, &end, 10);
+        if (end == text || *end != separator)
+            return false;
+        text = end + 1;
+    }
+
+    return true;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& opt)
+{
+    opt.output = nullptr;
+    opt.seed = 1;
+    opt.count = 1;
+    defaultShape(opt.shape);
+
+    for (int index = 1; index < argc; ++index)
+    {
+        const char* arg = argv[index];
+        if (index + 1 >= argc)
+            return false; /* every option takes a value */
+        const char* val = argv[++index];
+        GenShape& shape = opt.shape;
+        bool ok = true;
+
+        if (!strcmp(arg, "-o") || !strcmp(arg, "--output"))
+            opt.output = val;
+        else if (!strcmp(arg, "-s") || !strcmp(arg, "--seed"))
+            opt.seed = strtoull(val, nullptr, 10);
+        else if (!strcmp(arg, "-n") || !strcmp(arg, "--count"))
+            opt.count = (unsigned int)atoi(val);
+        else if (!strcmp(arg, "--size"))
+            ok = parseByteSize(val, shape.size);
+        else if (!strcmp(arg, "--depth"))
+            shape.maxDepth = (unsigned int)atoi(val);
+        else if (!strcmp(arg, "--width"))
+            ok = parseRange(val, shape.minWidth, shape.maxWidth);
+        else if (!strcmp(arg, "--length"))
+            ok = parseRange(val, shape.minLength, shape.maxLength);
+        else if (!strcmp(arg, "--string"))
+            ok = parseRange(val, shape.minString, shape.maxString);
+        else if (!strcmp(arg, "--key"))
+            ok = parseRange(val, shape.minKey, shape.maxKey);
+        else if (!strcmp(arg, "--escapes"))
+            ok = parseRate(val, shape.escapes);
+        else if (!strcmp(arg, "--unicode"))
+            ok = parseRate(val, shape.unicode);
+        else if (!strcmp(arg, "--utf8"))
+            ok = parseRate(val, shape.utf8);
+        else if (!strcmp(arg, "--containers"))
+            ok = parseRate(val, shape.containers);
+        else if (!strcmp(arg, "--objects"))
+            ok = parseRate(val, shape.objects);
+        else if (!strcmp(arg, "--kinds"))
+            ok = parseKinds(val, shape);
+        else
+            return false;
+        if (!ok)
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    for (int index = 1; index < argc; ++index)
+    {
+        if (!strcmp(argv[index], "-h") || !strcmp(argv[index], "--help"))
+        {
+            usage(stdout);
+            return 0;
+        }
+    }
+    if (!parseOptions(argc, argv, opt))
+    {
+        usage(stderr);
+        return 2;
+    }
+
+    FILE* fp = stdout;
+    if (opt.output != nullptr && (fp = fopen(opt.output, "wb")) == nullptr)
+    {
+        fprintf(stderr, "leptjson_gen: %s: cannot open output\n", opt.output);
+        return 1;
+    }
+
+    /* small documents are gathered into larger writes */
+    Generator gen(opt.shape, opt.seed);
+    std::string text;
+    bool ok = true;
+    for (unsigned int doc = 0; doc < opt.count && ok; ++doc)
+    {
+        gen.generate(text);
+        text += '\n';
+        if (text.size() >= GEN_WRITE_CHUNK || doc + 1 == opt.count)
+        {
+            ok = (fwrite(text.data(), 1, text.size(), fp) == text.size());
+            text.clear();
+        }
+    }
+    if (fp != stdout)
+        ok = (fclose(fp) == 0) && ok;
+    else
+        ok = (fflush(fp) == 0) && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "leptjson_gen: %s: cannot write output\n", opt.output != nullptr ? opt.output : "<stdout>");
+        return 1;
+    }
+
+    return 0;
+}
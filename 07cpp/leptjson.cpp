@@ -5,6 +5,44 @@
 #include <cerrno> /* errno, ERANGE */
 #include <queue> /* std::queue<> */
 #include <iomanip> /* std::setprecision() */
+#include <cstring> /* memcpy(), strcpy() */
+#include <cmath> /* HUGE_VAL, std::signbit(), std::isfinite() */
+#include <cfloat> /* DBL_MIN */
+#include <cstdint> /* uint64_t */
+#include <algorithm> /* std::max(), std::min() */
+#include <thread> /* std::thread */
+#include <mutex> /* std::mutex, std::unique_lock<> */
+#include <condition_variable> /* std::condition_variable */
+#include <atomic> /* std::atomic<> */
+#include <new> /* std::bad_alloc, std::nothrow_t */
+#include <cstddef> /* std::max_align_t */
+#include <fcntl.h> /* open() */
+#include <sys/stat.h> /* fstat(), _S_IREAD, _S_IWRITE */
+#ifdef _WIN32
+#include <io.h> /* _write(), _close() */
+#include <windows.h> /* MoveFileExA() */
+#else
+#include <unistd.h> /* write(), close(), fsync() */
+#include <sys/uio.h> /* writev(), struct iovec */
+#include <climits> /* IOV_MAX */
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LEPT_MINIFY_SSE2
+#include <emmintrin.h> /* _mm_cmpeq_epi8(), _mm_movemask_epi8() */
+#if defined(__GNUC__)
+#define LEPT_MINIFY_SSSE3 /* built for CPUs that have it, chosen at run time */
+#include <tmmintrin.h> /* _mm_shuffle_epi8() */
+#endif
+#endif
+#ifdef _MSC_VER
+#include <intrin.h> /* _BitScanForward64(), __rdtsc() */
+#endif
+#ifdef LEPT_CONTEXT_STATS
+#include <chrono> /* std::chrono::steady_clock, where there is no rdtsc */
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> /* __rdtsc() */
+#endif
+#endif
 // #include <type_traits> /* std::is_same<>::value */
 
 /* macros */
@@ -15,6 +53,33 @@
         c->txtIncre(); \
     } while (0)
 
+#ifdef _WIN32
+#define LEPT_OPEN_WRITE(path) ::_open((path), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define LEPT_OPEN_READ(path) ::_open((path), _O_RDONLY | _O_BINARY)
+#define LEPT_WRITE(fd, data, len) ::_write((fd), (data), (unsigned int)(len))
+#define LEPT_READ(fd, data, len) ::_read((fd), (data), (unsigned int)(len))
+#define LEPT_REWIND(fd) ::_lseeki64((fd), 0, SEEK_SET)
+#define LEPT_FSYNC(fd) ::_commit(fd)
+#define LEPT_CLOSE(fd) ::_close(fd)
+#define LEPT_RENAME(from, to) (MoveFileExA((from), (to), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : -1)
+#define LEPT_UNLINK(path) ::_unlink(path)
+#else
+#define LEPT_OPEN_WRITE(path) ::open((path), O_WRONLY | O_CREAT | O_TRUNC, 0644)
+#define LEPT_OPEN_READ(path) ::open((path), O_RDONLY)
+#define LEPT_WRITE(fd, data, len) ::write((fd), (data), (len))
+#define LEPT_READ(fd, data, len) ::read((fd), (data), (len))
+#define LEPT_REWIND(fd) ::lseek((fd), 0, SEEK_SET)
+#define LEPT_FSYNC(fd) ::fsync(fd)
+#define LEPT_CLOSE(fd) ::close(fd)
+#define LEPT_RENAME(from, to) ::rename((from), (to))
+#define LEPT_UNLINK(path) ::unlink(path)
+#endif
+
+/* stripped output collected before it goes to the writer */
+#ifndef LEPT_MINIFY_BUFFER_SIZE
+#define LEPT_MINIFY_BUFFER_SIZE 65536
+#endif
+
 #define IS_DIGIT(ch) \
     ((ch) >= '0' && (ch) <= '9')
 #define IS_DIGIT_NONZERO(ch) \
@@ -38,895 +103,3823 @@
             )\
         )\
     )
-
-#define INDENT(value, cache) \
-    do {\
-        for (unsigned int index = 0; index < value->getLevel(); ++index)\
-            cache.append("\t"); \
-    } while (0)
 #endif
 
 
-/* ------- Lept::Value -------- */
+/* -------- allocation accounting -------- */
 #if 1
-// Constructor; 
-Lept::Value::Value(Lept::Type type) :
-    m_type(type), 
-    m_level(0)
+#ifdef LEPT_ALLOC_STATS
+/* the size of each block sits in front of it, keeping the alignment operator new promises */
+#define ALLOC_HEADER_SIZE alignof(std::max_align_t)
+#define ALLOC_PHASES 4
+/* kept out of callers in this file, where GCC would see free() meet a pointer from operator new */
+#if defined(__GNUC__)
+#define ALLOC_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define ALLOC_NOINLINE __declspec(noinline)
+#else
+#define ALLOC_NOINLINE
+#endif
+
+typedef struct
 {
-    switch (type)
-    {
-    case Lept::Type::STRING:
-        this->m_str = new std::string;
-        break; 
-    case Lept::Type::ARRAY:
-        this->m_arr = new std::vector<Lept::Value*>; 
-        break; 
-    default:
-        this->m_num = 0.0; 
-        break; 
-    }
-}
-// Destructor; 
-Lept::Value::~Value(void)
+    std::atomic<size_t> allocs; 
+    std::atomic<size_t> frees; 
+    std::atomic<size_t> bytes; 
+    std::atomic<size_t> freedBytes; 
+    std::atomic<size_t> peak; 
+} AllocCounters;
+
+/* constant-initialized, ready before any static constructor allocates */
+static AllocCounters allocCounters[ALLOC_PHASES]; 
+static std::atomic<size_t> allocLive(0); 
+static thread_local Lept::AllocPhase allocPhase = Lept::AllocPhase::OTHER; 
+
+/* attributes what the enclosing library call allocates and frees, the innermost scope wins */
+class AllocScope
 {
-    Lept::Type type = this->getType(); 
+private:
+    Lept::AllocPhase m_outer; 
 
-    switch (type)
+public:
+    // Constructor; 
+    AllocScope(Lept::AllocPhase phase) :
+        m_outer(allocPhase)
     {
-    case Lept::Type::STRING:
-        delete this->m_str; 
-        break; 
-    case Lept::Type::ARRAY:
-        int len; 
-        len = this->m_arr->size() - 1; 
-        for (; len >= 0; --len)
-            delete this->getArrElem(len); 
-        delete this->m_arr; 
-        break;
-    case Lept::Type::OBJECT:
-        len = this->m_obj->size() - 1;
-        for (; len >= 0; --len)
-        {
-            delete this->getObjElem(len)->key;
-            delete this->getObjElem(len)->value;
-            delete this->getObjElem(len);
-        }
-        delete this->m_obj;
-        break;
-    default:
-        break; 
+        allocPhase = phase; 
     }
-}
+    // Destructor; 
+    ~AllocScope(void)
+    {
+        allocPhase = this->m_outer; 
+    }
+};
+#define LEPT_ALLOC_SCOPE(phase) AllocScope allocScope(phase)
 
-/* get-Functions */
-Lept::Type Lept::Value::getType(void) const
-{
-    return this->m_type;
-}
-bool Lept::Value::getBoolean(void) const
+static void allocRecord(size_t size)
 {
-    assert(this->getType() == Lept::Type::TRUE || this->getType() == Lept::Type::FALSE); 
+    AllocCounters& counters = allocCounters[(int)allocPhase]; 
+    size_t live = allocLive.fetch_add(size, std::memory_order_relaxed) + size; 
+    counters.allocs.fetch_add(1, std::memory_order_relaxed); 
+    counters.bytes.fetch_add(size, std::memory_order_relaxed); 
 
-    return (this->getType() == Lept::Type::TRUE); 
-}
-double Lept::Value::getNum(void) const
-{
-    assert(this->getType() == Lept::Type::NUMBER); 
+    size_t peak = counters.peak.load(std::memory_order_relaxed); 
+    while (live > peak && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        ; 
 
-    return this->m_num; 
+    return; 
 }
-std::string* Lept::Value::getStr(void) const
+static void allocRelease(size_t size)
 {
-    assert(this->getType() == Lept::Type::STRING); 
+    AllocCounters& counters = allocCounters[(int)allocPhase]; 
+    allocLive.fetch_sub(size, std::memory_order_relaxed); 
+    counters.frees.fetch_add(1, std::memory_order_relaxed); 
+    counters.freedBytes.fetch_add(size, std::memory_order_relaxed); 
 
-    return this->m_str; 
+    return; 
 }
-std::vector<Lept::Value*>* Lept::Value::getArr(void) const
-{
-    assert(this->getType() == Lept::Type::ARRAY);
+#else
+#define LEPT_ALLOC_SCOPE(phase)
+#endif
 
-    return this->m_arr;
-}
-Lept::Value* Lept::Value::getArrElem(void) const
+Lept::AllocStats Lept::getAllocStats(Lept::AllocPhase phase)
 {
-    assert(this->getType() == Lept::Type::ARRAY);
+    Lept::AllocStats stats = { 0, 0, 0, 0, 0 }; 
+#ifdef LEPT_ALLOC_STATS
+    const AllocCounters& counters = allocCounters[(int)phase]; 
+    stats.allocs = counters.allocs.load(std::memory_order_relaxed); 
+    stats.frees = counters.frees.load(std::memory_order_relaxed); 
+    stats.bytes = counters.bytes.load(std::memory_order_relaxed); 
+    stats.freedBytes = counters.freedBytes.load(std::memory_order_relaxed); 
+    stats.peak = counters.peak.load(std::memory_order_relaxed); 
+#else
+    (void)phase; 
+#endif
 
-    return this->m_arr->at(this->m_arr->size() - 1);
+    return stats; 
 }
-Lept::Value* Lept::Value::getArrElem(unsigned int index) const
+size_t Lept::getLiveBytes(void)
 {
-    assert(this->getType() == Lept::Type::ARRAY);
-
-    return this->m_arr->at(index);
+#ifdef LEPT_ALLOC_STATS
+    return allocLive.load(std::memory_order_relaxed); 
+#else
+    return 0; 
+#endif
 }
-std::vector<Lept::Member*>* Lept::Value::getObj(void) const
+void Lept::resetAllocStats(void)
 {
-    assert(this->getType() == Lept::Type::OBJECT);
+#ifdef LEPT_ALLOC_STATS
+    size_t live = allocLive.load(std::memory_order_relaxed); 
+    for (AllocCounters& counters : allocCounters)
+    {
+        counters.allocs.store(0, std::memory_order_relaxed); 
+        counters.frees.store(0, std::memory_order_relaxed); 
+        counters.bytes.store(0, std::memory_order_relaxed); 
+        counters.freedBytes.store(0, std::memory_order_relaxed); 
+        counters.peak.store(live, std::memory_order_relaxed); 
+    }
+#endif
 
-    return this->m_obj;
+    return; 
 }
-Lept::Member* Lept::Value::getObjElem(void) const
-{
-    assert(this->getType() == Lept::Type::OBJECT);
 
-    return this->m_obj->at(this->m_obj->size() - 1);
-}
-Lept::Member* Lept::Value::getObjElem(unsigned int index) const
+#ifdef LEPT_ALLOC_STATS
+/* every allocation of the process goes through here, std::string and std::vector buffers included */
+ALLOC_NOINLINE void* operator new(size_t size)
 {
-    assert(this->getType() == Lept::Type::OBJECT);
+    char* block = (char*)malloc(size + ALLOC_HEADER_SIZE); 
+    if (block == nullptr)
+        throw std::bad_alloc(); 
+    *(size_t*)block = size; 
+    allocRecord(size); 
 
-    return this->m_obj->at(index);
+    return block + ALLOC_HEADER_SIZE; 
 }
-int Lept::Value::getLevel(void) const
+void* operator new[](size_t size)
 {
-    return this->m_level; 
+    return operator new(size); 
 }
-
-/* set-Functions */
-void Lept::Value::setType(Lept::Type type)
+void* operator new(size_t size, const std::nothrow_t&) noexcept
 {
-    int len = 0;
-
-    switch (this->m_type)
+    try
     {
-    case Lept::Type::STRING:
-        delete this->m_str;
-        break; 
-    case Lept::Type::ARRAY:
-        len = this->m_arr->size() - 1;
-        for (; len >= 0; --len)
-            delete this->getArrElem(len);
-        delete this->m_arr; 
-        break; 
-    case Lept::Type::OBJECT:
-        len = this->m_obj->size() - 1;
-        for (; len >= 0; --len)
-        {
-            delete this->getObjElem(len)->key;
-            delete this->getObjElem(len)->value;
-            delete this->getObjElem(len);
-        }
-        delete this->m_obj;
-        break;
-    default:
-        break; 
+        return operator new(size); 
     }
-
-    this->m_type = type;
-    switch (type)
+    catch (const std::bad_alloc&)
     {
-    case Lept::Type::STRING:
-        this->m_str = new std::string; 
-        break; 
-    case Lept::Type::ARRAY:
-        this->m_arr = new std::vector<Lept::Value*>; 
-        break; 
-    case Lept::Type::OBJECT:
-        this->m_obj = new std::vector<Lept::Member*>; 
-        break; 
-    default:
-        this->m_num = 0.0; 
-        break; 
+        return nullptr; 
     }
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag); 
+}
+ALLOC_NOINLINE void operator delete(void* ptr) noexcept
+{
+    if (ptr == nullptr)
+        return; 
+
+    char* block = (char*)ptr - ALLOC_HEADER_SIZE; 
+    allocRelease(*(size_t*)block); 
+    free(block); 
 
     return; 
 }
-void Lept::Value::setNull(void)
+void operator delete[](void* ptr) noexcept
 {
-    this->setType(Lept::Type::NULLJSON); 
+    operator delete(ptr); 
 
     return; 
 }
-void Lept::Value::setBoolean(bool bln)
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
 {
-    this->setType(bln ? Lept::Type::TRUE : Lept::Type::FALSE);
+    operator delete(ptr); 
 
-    return;
+    return; 
 }
-void Lept::Value::setNum(double num)
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
 {
-    this->setType(Lept::Type::NUMBER);
-    this->m_num = num; 
+    operator delete(ptr); 
 
     return; 
 }
-void Lept::Value::setStrNew(void)
-{
-    assert(this->getType() == Lept::Type::STRING); 
+#endif
+#endif
 
-    this->m_str = new std::string; 
+/* ------- Lept::Format -------- */
+#if 1
+// Constructor; 
+Lept::Format::Format(char indentChar, unsigned int indentWidth, Lept::Newline newline, unsigned int maxWidth) :
+    m_indentChar(indentChar), 
+    m_indentWidth(indentWidth), 
+    m_newline(newline), 
+    m_maxWidth(maxWidth)
+{
+    this->buildIndentBuffer(); 
+}
+// Destructor; 
+Lept::Format::~Format(void)
+{
 
-    return; 
 }
-void Lept::Value::setStr(std::string* str)
+
+/* precompute line break and indentation so that breakLine() costs one append */
+void Lept::Format::buildIndentBuffer(void)
 {
-    assert(this->getType() == Lept::Type::STRING);
+    this->m_indentBuffer.clear(); 
+    if (this->isCompact())
+        return; 
 
-    this->m_str = str; 
+    if (this->getNewline() == Lept::Newline::CRLF)
+        this->m_indentBuffer.push_back('\r'); 
+    this->m_indentBuffer.push_back('\n'); 
+    this->m_indentBuffer.append((size_t)LEPT_INDENT_CACHE_LEVEL * this->getIndentWidth(), this->getIndentChar()); 
 
     return; 
 }
-void Lept::Value::setStr(std::string str)
+
+/* get-Functions */
+char Lept::Format::getIndentChar(void) const
 {
-    assert(this->getType() == Lept::Type::STRING);
+    return this->m_indentChar; 
+}
+unsigned int Lept::Format::getIndentWidth(void) const
+{
+    return this->m_indentWidth; 
+}
+Lept::Newline Lept::Format::getNewline(void) const
+{
+    return this->m_newline; 
+}
+unsigned int Lept::Format::getMaxWidth(void) const
+{
+    return this->m_maxWidth; 
+}
+bool Lept::Format::isCompact(void) const
+{
+    return (this->getNewline() == Lept::Newline::NONE); 
+}
 
-    *this->m_str = str;
+/* set-Functions */
+void Lept::Format::setIndentChar(char indentChar)
+{
+    this->m_indentChar = indentChar; 
+    this->buildIndentBuffer(); 
 
-    return;
+    return; 
 }
-void Lept::Value::appendChar(char ch)
+void Lept::Format::setIndentWidth(unsigned int indentWidth)
 {
-    assert(this->getType() == Lept::Type::STRING); 
-
-    this->m_str->push_back(ch); 
+    this->m_indentWidth = indentWidth; 
+    this->buildIndentBuffer(); 
 
     return; 
 }
-void Lept::Value::appendArrElem(Lept::Value &elem)
+void Lept::Format::setNewline(Lept::Newline newline)
 {
-    assert(this->getType() == Lept::Type::ARRAY);
+    this->m_newline = newline; 
+    this->buildIndentBuffer(); 
 
-    this->m_arr->push_back(&elem); 
+    return; 
+}
+void Lept::Format::setMaxWidth(unsigned int maxWidth)
+{
+    this->m_maxWidth = maxWidth; 
 
     return; 
 }
-void Lept::Value::appendObjElem(Lept::Member& elem)
+
+size_t Lept::Format::breakLineSize(int level) const
 {
-    assert(this->getType() == Lept::Type::OBJECT);
+    if (this->isCompact())
+        return 0; 
 
-    this->m_obj->push_back(&elem);
+    size_t newlineLen = (this->getNewline() == Lept::Newline::CRLF) ? 2 : 1; 
 
-    return;
+    return newlineLen + (size_t)level * this->getIndentWidth(); 
 }
-void Lept::Value::setLevel(int level)
+void Lept::Format::breakLine(Lept::Writer& w, int level) const
 {
-    this->m_level = level; 
+    if (this->isCompact())
+        return; 
+
+    const char* buffer = this->m_indentBuffer.data(); 
+    size_t cached = this->m_indentBuffer.size(); 
+    size_t newlineLen = (this->getNewline() == Lept::Newline::CRLF) ? 2 : 1; 
+    size_t len = newlineLen + (size_t)level * this->getIndentWidth(); 
+
+    if (len <= cached)
+    {
+        w.write(buffer, len); 
+        return; 
+    }
+
+    /* deeper than cached, write the indentation block by block */
+    size_t block = cached - newlineLen; 
+    w.write(buffer, cached); 
+    for (len -= cached; len > block; len -= block)
+        w.write(buffer + newlineLen, block); 
+    w.write(buffer + newlineLen, len); 
 
     return; 
 }
-void Lept::Value::levelUp(void)
-{
-    ++this->m_level;
+#endif
 
-    return;
+
+/* ------- Lept::Writer -------- */
+#if 1
+/* char following the backslash of the escape of ch, 'u' for \u00xx, '\0' if unescaped */
+static char escapeOf(unsigned char ch)
+{
+    switch (ch)
+    {
+    case '\"': return '\"'; 
+    case '\\': return '\\'; 
+    case '/': return '/'; 
+    case '\b': return 'b'; 
+    case '\f': return 'f'; 
+    case '\n': return 'n'; 
+    case '\r': return 'r'; 
+    case '\t': return 't'; 
+    default:
+        return (ch < 0x20) ? 'u' : '\0'; 
+    }
 }
-void Lept::Value::levelDown(void)
+/* length of str once quoted and escaped by Writer::writeString() */
+static size_t escapedSize(const std::string& str)
 {
-    --this->m_level;
+    size_t size = str.size() + 2; 
 
-    return;
+    for (size_t index = 0; index < str.size(); ++index)
+    {
+        char esc = escapeOf((unsigned char)str[index]); 
+        if (esc == 'u')
+            size += 5; 
+        else if (esc != '\0')
+            size += 1; 
+    }
+
+    return size; 
 }
 
-/* parse JSON context to tree context */
-int Lept::Value::parse(Lept::Context &c)
+/* length of "%.17g" of num, integers are counted without formatting them */
+static size_t numberSize(double num)
 {
-    int ret = Lept::PARSE_OK;
+    if (num > -1e17 && num < 1e17 && num == (double)(long long)num)
+    {
+        unsigned long long abs = (unsigned long long)(num < 0 ? -num : num); 
+        size_t size = std::signbit(num) ? 2 : 1; /* "-0" keeps its sign */
+        for (; abs >= 10; abs /= 10)
+            ++size; 
+        return size; 
+    }
 
-    this->setType(Lept::Type::NULLJSON); // by default set NULL data; 
-    c.parseWs(); // skip the leading ws; 
+    char buffer[32]; 
+    return (size_t)snprintf(buffer, sizeof(buffer), "%.17g", num); 
+}
+/* length of v without line breaks, or more than limit as soon as it cannot fit, 
+ * so that a container costs at most about limit bytes of lookahead whatever its size */
+static size_t compactSize(const Lept::Value& v, size_t limit)
+{
+    size_t size = 0, len = 0; 
 
-    if ((ret = c.parseValue(*this)) == Lept::PARSE_OK)
+    switch (v.getType())
     {
-        c.parseWs();
-        if (*c.getTxt() != '\0')
+    case Lept::Type::NULLJSON:
+    case Lept::Type::TRUE:
+        return 4; 
+    case Lept::Type::FALSE:
+        return 5; 
+    case Lept::Type::NUMBER:
+        return numberSize(v.getNum()); 
+    case Lept::Type::STRING:
+        if (v.getStr()->size() + 2 > limit)
+            return limit + 1; 
+        return escapedSize(*v.getStr()); 
+    case Lept::Type::ARRAY:
+        len = v.getArr()->size(); 
+        /* brackets, commas and at least a byte per element */
+        size = (len != 0) ? len * 2 + 1 : 2; 
+        if (size > limit)
+            return limit + 1; 
+        size -= len; 
+        for (size_t index = 0; index < len && size <= limit; ++index)
+            size += compactSize(*v.getArr()->at(index), limit - size + 1); 
+        break; 
+    case Lept::Type::OBJECT:
+        len = v.getObj()->size(); 
+        /* braces, commas, and at least "":0 per member */
+        size = (len != 0) ? len * 5 + 1 : 2; 
+        if (size > limit)
+            return limit + 1; 
+        size = (len != 0) ? len * 2 + 1 : 2; /* braces, commas and colons */
+        for (size_t index = 0; index < len && size <= limit; ++index)
         {
-            this->setType(Lept::Type::NULLJSON);
-            ret = Lept::PARSE_ROOT_NOT_SINGULAR;
+            const std::string& key = *v.getObj()->at(index)->key; 
+            if (size + key.size() + 2 > limit) /* no scan of long keys, as for string values */
+                return limit + 1; 
+            size += escapedSize(key); 
+            if (size <= limit)
+                size += compactSize(*v.getObj()->at(index)->value, limit - size + 1); 
         }
+        break; 
     }
 
-    return ret;
+    return std::min(size, limit + 1); 
 }
-int Lept::Value::parse(const char* json)
+/* whether container v, opened at column, is kept on one line under the maximum width, 
+ * one column is left for the comma that may follow it */
+static bool fitsLine(const Lept::Value& v, const Lept::Format& fmt, size_t column)
 {
-    Lept::Context c(json); // create JSON context; 
+    size_t width = fmt.getMaxWidth(); 
+    if (width == 0 || fmt.isCompact() || column + 1 >= width)
+        return false; 
 
-    return this->parse(c); 
+    return compactSize(v, width - column - 1) <= width - column - 1; 
 }
-int Lept::Value::parse(std::string json)
+
+// Constructor; 
+Lept::Writer::Writer(const Lept::Format& fmt) :
+    m_fmt(&fmt), 
+    m_level(0), 
+    m_status(Lept::STRINGIFY_OK), 
+    m_inline(false), 
+    m_drained(0), 
+    m_lineStart(0), 
+    m_used(0)
 {
-    char* str = new char[json.size() + 1]; 
-    strcpy(str, json.c_str()); 
-    Lept::Context c(str); 
-    int ret = this->parse(c); 
-    delete[] str; 
 
-    return ret; 
 }
-
-/* JSON stringifier components*/
-#if 1
-int Lept::Value::stringifyLiteral(std::string& JSONCache) const
+// Destructor; 
+Lept::Writer::~Writer(void)
 {
-    Lept::Type type = this->getType();
-    assert(type == Lept::Type::NULLJSON || this->getType() == Lept::Type::FALSE || this->getType() == Lept::Type::TRUE); 
-    
-    switch (type)
-    {
-    case Lept::Type::NULLJSON:
-        JSONCache.append("null"); 
-        break;
-    case Lept::Type::FALSE:
-        JSONCache.append("false");
-        break;
-    case Lept::Type::TRUE:
-        JSONCache.append("true");
-        break;
-    }
+    /* sinks flush in their own destructors, drain() is gone by now */
+}
 
-    return Lept::STRINGIFY_OK; 
+/* get-Functions */
+const Lept::Format& Lept::Writer::getFormat(void) const
+{
+    return *this->m_fmt; 
 }
-int Lept::Value::stringifyNumber(std::string& JSONCache) const
+int Lept::Writer::getLevel(void) const
 {
-    assert(this->getType() == Lept::Type::NUMBER); 
+    return this->m_level; 
+}
+int Lept::Writer::getStatus(void) const
+{
+    return this->m_status; 
+}
+size_t Lept::Writer::getColumn(void) const
+{
+    return this->m_drained + this->m_used - this->m_lineStart; 
+}
+bool Lept::Writer::isInline(void) const
+{
+    return this->m_inline; 
+}
 
-    char buffer[32]; 
-    sprintf(buffer, "%.17g", this->getNum());
-    JSONCache.append(buffer);
+/* set-Functions */
+void Lept::Writer::setStatus(int status)
+{
+    /* keep the first error */
+    if (this->m_status == Lept::STRINGIFY_OK)
+        this->m_status = status; 
 
-    return Lept::STRINGIFY_OK; 
+    return; 
 }
-/* CAUTION: \uxxxx escapes remain to be fixed */
-int Lept::Value::stringifyString(std::string& JSONCache) const
+void Lept::Writer::levelUp(void)
 {
-    assert(this->getType() == Lept::Type::STRING);
-
-    JSONCache.append("\"");
-    
-    const std::string* p = this->getStr();
-    unsigned int len = p->size(), index = 0; 
-    char cur; 
-    while (index < len)
-    {
-        /* excape chars except \uxxxx */
-        cur = p->at(index); 
-        switch (cur)
-        {
-        case '\"': JSONCache.append("\\\""); break; 
-        case '\\': JSONCache.append("\\\\"); break;
-        case '/': JSONCache.append("\\/"); break;
-        case '\b': JSONCache.append("\\b"); break;
-        case '\f': JSONCache.append("\\f"); break;
-        case '\n': JSONCache.append("\\n"); break;
-        case '\r': JSONCache.append("\\r"); break;
-        case '\t': JSONCache.append("\\t"); break;
-        default:
-            if (cur < 0x20) 
-            {
-                /* \uxxxx escapes remain to be fixed */
-            }
-            else 
-                JSONCache.append(p->substr(index, 1)); 
-            break;
-        }
-        ++index; 
-    }
+    ++this->m_level; 
 
-    JSONCache.append("\"");
+    return; 
+}
+void Lept::Writer::levelDown(void)
+{
+    --this->m_level; 
 
-    return Lept::STRINGIFY_OK;
+    return; 
 }
-int Lept::Value::stringifyArray(std::string& JSONCache)
+void Lept::Writer::setInline(bool isInline)
 {
-    assert(this->getType() == Lept::Type::ARRAY);
-    int ret = Lept::STRINGIFY_OK; 
+    this->m_inline = isInline; 
 
-    unsigned int len = this->getArr()->size();
-    JSONCache.append("[\n");
-    this->levelUp();
-    if (len != 0) // beautifiy empty array; 
-        INDENT(this, JSONCache);
+    return; 
+}
 
-    for (unsigned int index = 0; index < len; ++index)
+/* append to output */
+void Lept::Writer::put(char ch)
+{
+    if (this->m_used == LEPT_WRITER_BUFFER_SIZE)
+        this->flush(); 
+    this->m_buffer[this->m_used++] = ch; 
+
+    return; 
+}
+void Lept::Writer::write(const char* str, size_t len)
+{
+    if (len > LEPT_WRITER_BUFFER_SIZE - this->m_used)
     {
-        this->getArr()->at(index)->setLevel(this->getLevel()); 
-        ret = this->getArr()->at(index)->stringify(JSONCache);
-        if (ret != Lept::STRINGIFY_OK)
-            return ret;
-        if (index != len - 1)
+        this->flush(); 
+        /* too large to be worth buffering, hand it over directly */
+        if (len >= LEPT_WRITER_BUFFER_SIZE)
         {
-            JSONCache.append(",\n");
-            INDENT(this, JSONCache);
+            if (this->getStatus() == Lept::STRINGIFY_OK)
+                this->setStatus(this->drain(str, len)); 
+            this->m_drained += len; 
+            return; 
         }
-        else
-            JSONCache.append("\n");
     }
-    this->levelDown();
-    INDENT(this, JSONCache);
-    JSONCache.append("]");
+    memcpy(this->m_buffer + this->m_used, str, len); 
+    this->m_used += len; 
 
-    return ret;
+    return; 
 }
-int Lept::Value::stringifyObject(std::string& JSONCache)
+void Lept::Writer::writeString(const std::string& str)
 {
-    assert(this->getType() == Lept::Type::OBJECT);
-    int ret = Lept::STRINGIFY_OK;
+    static const char hexDigits[] = "0123456789ABCDEF"; 
+    const char* p = str.data(); 
+    size_t len = str.size(), head = 0; 
 
-    unsigned int len = this->getObj()->size();
-    JSONCache.append("{\n");
-    this->levelUp();
-    if (len != 0) // beautifiy empty object; 
-        INDENT(this, JSONCache);
-
-    Lept::Value cache(Lept::Type::STRING);
-    for (unsigned int index = 0; index < len; ++index)
+    this->put('\"'); 
+    for (size_t index = 0; index < len; ++index)
     {
-        cache.setStrNew(); 
-        cache.setStr(*this->getObj()->at(index)->key);
-        cache.stringifyString(JSONCache); 
-        JSONCache.append(":");
+        unsigned char cur = (unsigned char)p[index]; 
+        char esc = escapeOf(cur); 
 
-        this->getObj()->at(index)->value->setLevel(this->getLevel()); 
-        ret = this->getObj()->at(index)->value->stringify(JSONCache);
-        if (ret != Lept::STRINGIFY_OK)
-            return ret;
-        if (index != len - 1)
+        /* unescaped chars, UTF-8 bytes included, are appended run by run */
+        if (esc == '\0')
+            continue; 
+
+        this->write(p + head, index - head); 
+        head = index + 1; 
+        if (esc == 'u')
         {
-            JSONCache.append(",\n");
-            INDENT(this, JSONCache);
+            char buffer[6] = { '\\', 'u', '0', '0', hexDigits[cur >> 4], hexDigits[cur & 0xF] }; 
+            this->write(buffer, 6); 
         }
         else
-            JSONCache.append("\n"); 
+        {
+            char buffer[2] = { '\\', esc }; 
+            this->write(buffer, 2); 
+        }
     }
-    this->levelDown();
-    INDENT(this, JSONCache);
-    JSONCache.append("}");
+    this->write(p + head, len - head); 
+    this->put('\"'); 
 
-    return ret;
+    return; 
 }
-int Lept::Value::stringify(std::string& JSONCache)
+void Lept::Writer::breakLine(void)
 {
-    Lept::Type type = this->getType();
-    int ret = Lept::STRINGIFY_OK;
-    std::string copy = JSONCache;
-    if (this->getLevel() == 0)
-        JSONCache = {}; /* avoid rebundance when reusing JSONCache for another stringification */
+    if (this->m_inline)
+        return; 
 
-    switch (type)
-    {
-    case Lept::Type::NULLJSON:
-    case Lept::Type::FALSE:
-    case Lept::Type::TRUE:
-        ret = this->stringifyLiteral(JSONCache);
-        break;
-    case Lept::Type::NUMBER:
-        ret = this->stringifyNumber(JSONCache);
-        break;
-    case Lept::Type::STRING:
-        ret = this->stringifyString(JSONCache);
-        break;
-    case Lept::Type::ARRAY:
-        ret = this->stringifyArray(JSONCache);
-        break;
-    case Lept::Type::OBJECT:
-        ret = this->stringifyObject(JSONCache);
-        break;
-    }
+    const Lept::Format& fmt = this->getFormat(); 
+    fmt.breakLine(*this, this->getLevel()); 
+    /* the indentation is part of the new line */
+    if (!fmt.isCompact())
+        this->m_lineStart = this->m_drained + this->m_used - (size_t)this->getLevel() * fmt.getIndentWidth(); 
 
-    /* stringification failure, JSONCache rewrite to original value */
-    if (ret != Lept::STRINGIFY_OK)
-        JSONCache = copy; 
+    return; 
+}
+void Lept::Writer::endLine(void)
+{
+    if (this->getFormat().getNewline() == Lept::Newline::CRLF)
+        this->write("\r\n", 2); 
+    else
+        this->write("\n", 1); 
+    this->m_lineStart = this->m_drained + this->m_used; 
 
-    return ret;
+    return; 
+}
+void Lept::Writer::writeChunks(const std::vector<const std::string*>& chunks)
+{
+    for (size_t index = 0; index < chunks.size(); ++index)
+        this->write(chunks[index]->data(), chunks[index]->size()); 
+
+    return; 
+}
+void Lept::Writer::reserve(size_t len)
+{
+    /* a hint only, sinks that cannot use it ignore it */
+    (void)len; 
+
+    return; 
+}
+int Lept::Writer::flush(void)
+{
+    /* after a sink error, further output is dropped */
+    if (this->m_used != 0 && this->getStatus() == Lept::STRINGIFY_OK)
+        this->setStatus(this->drain(this->m_buffer, this->m_used)); 
+    this->m_drained += this->m_used; 
+    this->m_used = 0; 
+
+    return this->getStatus(); 
 }
-#endif
 #endif
 
 
-/* -------- Lept::Context -------- */
+/* ------- Lept::Writer sinks -------- */
 #if 1
-// Constructor; 
-Lept::Context::Context(const char* txt) :
-    m_txt(txt)
+Lept::StringWriter::StringWriter(std::string& JSONCache, const Lept::Format& fmt) :
+    Lept::Writer(fmt), 
+    m_cache(&JSONCache)
 {
 
 }
-// Destructor; 
-Lept::Context::~Context(void)
+Lept::StringWriter::~StringWriter(void)
+{
+    this->flush(); 
+}
+void Lept::StringWriter::reserve(size_t len)
 {
+    this->m_cache->reserve(this->m_cache->size() + len); 
 
+    return; 
 }
+int Lept::StringWriter::drain(const char* data, size_t len)
+{
+    this->m_cache->append(data, len); 
 
-/* get-Functions */
-const char* Lept::Context::getTxt(void) const
+    return Lept::STRINGIFY_OK; 
+}
+
+Lept::StreamWriter::StreamWriter(std::ostream& os, const Lept::Format& fmt) :
+    Lept::Writer(fmt), 
+    m_os(&os)
 {
-    return this->m_txt;
+
+}
+Lept::StreamWriter::~StreamWriter(void)
+{
+    this->flush(); 
 }
+int Lept::StreamWriter::drain(const char* data, size_t len)
+{
+    this->m_os->write(data, len); 
 
-/* set-Functions */
-void Lept::Context::setTxt(const char* txt)
+    return this->m_os->fail() ? Lept::STRINGIFY_FILE_WRITE_FAILURE : Lept::STRINGIFY_OK; 
+}
+
+Lept::StdioWriter::StdioWriter(FILE* fp, const Lept::Format& fmt) :
+    Lept::Writer(fmt), 
+    m_fp(fp)
 {
-    this->m_txt = txt;
 
-    return;
 }
-void Lept::Context::txtIncre(unsigned int inc)
+Lept::StdioWriter::~StdioWriter(void)
 {
-    this->setTxt(this->getTxt() + inc);
+    this->flush(); 
+}
+int Lept::StdioWriter::drain(const char* data, size_t len)
+{
+    if (fwrite(data, 1, len, this->m_fp) != len)
+        return Lept::STRINGIFY_FILE_WRITE_FAILURE; 
 
-    return;
+    return Lept::STRINGIFY_OK; 
 }
 
-/* JSON parser components */
-#if 1
-/* parse single value */
-void Lept::Context::parseWs(void)
+Lept::FdWriter::FdWriter(int fd, const Lept::Format& fmt) :
+    Lept::Writer(fmt), 
+    m_fd(fd)
 {
-    // cursor;
-    const char* p = this->getTxt();
-    // skip ws; 
-    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
-        ++p;
-    // move cursor to the first non-ws char; 
-    this->setTxt(p);
 
-    return;
 }
-int Lept::Context::parseLiteral(Lept::Value& v, const char* stdtxt, Lept::Type type)
+Lept::FdWriter::~FdWriter(void)
 {
-    EXPECT(this, stdtxt[0]);
-    unsigned int count = 1;
-    while (stdtxt[count] != '\0')
+    this->flush(); 
+}
+int Lept::FdWriter::getFd(void) const
+{
+    return this->m_fd; 
+}
+int Lept::FdWriter::drain(const char* data, size_t len)
+{
+    /* write() may take less than asked */
+    while (len != 0)
     {
-        if (this->getTxt()[count - 1] != stdtxt[count])
-            return Lept::PARSE_INVALID_VALUE;
-        ++count;
+        long ret = (long)LEPT_WRITE(this->getFd(), data, len); 
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue; 
+            return Lept::STRINGIFY_FILE_WRITE_FAILURE; 
+        }
+        data += ret; 
+        len -= (size_t)ret; 
     }
-    this->txtIncre(count - 1);
-    v.setType(type);
 
-    return Lept::PARSE_OK;
+    return Lept::STRINGIFY_OK; 
 }
-int Lept::Context::parseNumber(Lept::Value& v)
+
+void Lept::FdWriter::writeChunks(const std::vector<const std::string*>& chunks)
 {
-    const char* end = this->getTxt();
-    /* validate legal number */
+#ifdef _WIN32
+    this->Lept::Writer::writeChunks(chunks); 
+#else
+    /* hand the chunks to the kernel without joining them first */
+    if (this->flush() != Lept::STRINGIFY_OK)
+        return; 
+
+    struct iovec iov[IOV_MAX]; 
+    size_t head = 0; 
+    while (head < chunks.size())
+    {
+        int count = 0; 
+        for (; count < IOV_MAX && head + count < chunks.size(); ++count)
+        {
+            iov[count].iov_base = (void*)chunks[head + count]->data(); 
+            iov[count].iov_len = chunks[head + count]->size(); 
+        }
+        head += count; 
 
-    if (*end == '-')
-        end += 1;
+        struct iovec* cur = iov; 
+        while (count != 0)
+        {
+            long ret = (long)writev(this->getFd(), cur, count); 
+            if (ret < 0)
+            {
+                if (errno == EINTR)
+                    continue; 
+                this->setStatus(Lept::STRINGIFY_FILE_WRITE_FAILURE); 
+                return; 
+            }
+            /* skip what was written, possibly stopping inside a chunk */
+            while (count != 0 && (size_t)ret >= cur->iov_len)
+            {
+                ret -= (long)cur->iov_len; 
+                ++cur; 
+                --count; 
+            }
+            if (count != 0)
+            {
+                cur->iov_base = (char*)cur->iov_base + ret; 
+                cur->iov_len -= (size_t)ret; 
+            }
+        }
+    }
+#endif
 
-    if (!IS_DIGIT(*end))
-        return Lept::PARSE_INVALID_VALUE;
-    else if (IS_DIGIT_NONZERO(*end))
+    return; 
+}
+
+Lept::FileWriter::FileWriter(const char* path, const Lept::Format& fmt) :
+    Lept::FdWriter(LEPT_OPEN_WRITE(path), fmt)
+{
+    if (this->getFd() < 0)
+        this->setStatus(Lept::STRINGIFY_FILE_OPEN_FAILURE); 
+}
+Lept::FileWriter::~FileWriter(void)
+{
+    this->flush(); 
+    if (this->getFd() >= 0)
+        LEPT_CLOSE(this->getFd()); 
+}
+void Lept::FileWriter::reserve(size_t len)
+{
+#ifdef __linux__
+    /* the file was just truncated, allocate its blocks up front without changing its size, 
+     * filesystems without fallocate() support simply fail here */
+    if (this->getFd() >= 0 && len != 0)
+        fallocate(this->getFd(), FALLOC_FL_KEEP_SIZE, 0, (off_t)len); 
+#else
+    (void)len; 
+#endif
+
+    return; 
+}
+
+/* write all of data to fd, false on failure */
+static bool writeFull(int fd, const char* data, size_t len)
+{
+    while (len != 0)
     {
-        do
+        long ret = (long)LEPT_WRITE(fd, data, len); 
+        if (ret < 0)
         {
-            end += 1;
-        } while (IS_DIGIT(*end));
+            if (errno == EINTR)
+                continue; 
+            return false; 
+        }
+        data += ret; 
+        len -= (size_t)ret; 
     }
-    else
-        end += 1;
 
-    if (*end == '.')
+    return true; 
+}
+/* read up to len bytes of fd, fewer only at end of file, -1 on failure */
+static long readFull(int fd, char* data, size_t len)
+{
+    size_t got = 0; 
+    while (got < len)
     {
-        if (!IS_DIGIT(*(end + 1)))
-            return Lept::PARSE_INVALID_VALUE;
-        do
+        long ret = (long)LEPT_READ(fd, data + got, len - got); 
+        if (ret < 0)
         {
-            end += 1;
-        } while (IS_DIGIT(*end));
+            if (errno == EINTR)
+                continue; 
+            return -1; 
+        }
+        if (ret == 0)
+            break; 
+        got += (size_t)ret; 
     }
 
-    if (*end == 'e' || *end == 'E')
+    return (long)got; 
+}
+
+Lept::ReplaceWriter::ReplaceWriter(const char* path, const Lept::Format& fmt) :
+    Lept::Writer(fmt), 
+    m_path(path), 
+    m_tempPath(), 
+    m_original(LEPT_OPEN_READ(path)), 
+    m_temp(-1), 
+    m_same(0), 
+    m_chunk(), 
+    m_changed(false)
+{
+    if (this->m_original < 0)
+        this->setStatus(Lept::STRINGIFY_FILE_OPEN_FAILURE); 
+}
+Lept::ReplaceWriter::~ReplaceWriter(void)
+{
+    if (this->m_temp >= 0)
+        LEPT_CLOSE(this->m_temp); 
+    if (!this->m_tempPath.empty())
+        LEPT_UNLINK(this->m_tempPath.c_str()); 
+    if (this->m_original >= 0)
+        LEPT_CLOSE(this->m_original); 
+}
+bool Lept::ReplaceWriter::isChanged(void) const
+{
+    return this->m_changed; 
+}
+int Lept::ReplaceWriter::openTemp(size_t prefix)
+{
+#ifdef _WIN32
+    this->m_tempPath = this->m_path + ".tmp"; 
+    this->m_temp = ::_open(this->m_tempPath.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE); 
+#else
+    this->m_tempPath = this->m_path + ".XXXXXX"; 
+    this->m_temp = mkstemp(&this->m_tempPath[0]); 
+    struct stat st; 
+    if (this->m_temp >= 0 && fstat(this->m_original, &st) == 0)
+        fchmod(this->m_temp, st.st_mode & 07777); /* mkstemp() creates 0600 */
+#endif
+    if (this->m_temp < 0)
     {
-        end += 1;
-        if (*end == '+' || *end == '-')
-            end += 1;
-        if (!IS_DIGIT(*end))
-            return Lept::PARSE_INVALID_VALUE;
-        while (IS_DIGIT(*end))
-            end += 1;
+        this->m_tempPath.clear(); 
+        return Lept::STRINGIFY_FILE_OPEN_FAILURE; 
     }
 
-    errno = 0;
-    v.setType(Lept::Type::NUMBER); /* set type to make setNum available */
-    v.setNum(strtod(this->getTxt(), nullptr));
-    this->setTxt(end);
+    /* the equal part is copied from the original, output before it is already gone */
+    if (LEPT_REWIND(this->m_original) < 0)
+        return Lept::STRINGIFY_FILE_WRITE_FAILURE; 
+    this->m_chunk.resize(LEPT_WRITER_BUFFER_SIZE); 
+    while (prefix != 0)
+    {
+        size_t len = std::min(prefix, this->m_chunk.size()); 
+        if (readFull(this->m_original, this->m_chunk.data(), len) != (long)len || !writeFull(this->m_temp, this->m_chunk.data(), len))
+            return Lept::STRINGIFY_FILE_WRITE_FAILURE; 
+        prefix -= len; 
+    }
 
-    /* overflow detection */
-    if (errno = ERANGE && (v.getNum() == HUGE_VAL || v.getNum() == -HUGE_VAL))
+    return Lept::STRINGIFY_OK; 
+}
+int Lept::ReplaceWriter::drain(const char* data, size_t len)
+{
+    /* compared a buffer at a time, however much the writer hands over at once */
+    this->m_chunk.resize(LEPT_WRITER_BUFFER_SIZE); 
+    while (this->m_temp < 0 && len != 0)
     {
-        v.setType(Lept::Type::NULLJSON);
-        return Lept::PARSE_NUMBER_OVERFLOW;
+        size_t slice = std::min(len, this->m_chunk.size()); 
+        long got = readFull(this->m_original, this->m_chunk.data(), slice); 
+        if (got < 0)
+            return Lept::STRINGIFY_FILE_WRITE_FAILURE; 
+
+        /* stop comparing at the first difference */
+        size_t same = 0; 
+        if ((size_t)got == slice && memcmp(data, this->m_chunk.data(), slice) == 0)
+            same = slice; 
+        else
+        {
+            while (same < (size_t)got && data[same] == this->m_chunk[same])
+                ++same; 
+        }
+        this->m_same += same; 
+        data += same; 
+        len -= same; 
+        if (same == slice)
+            continue; 
+
+        int ret = this->openTemp(this->m_same); 
+        if (ret != Lept::STRINGIFY_OK)
+            return ret; 
     }
-    return Lept::PARSE_OK;
+    if (len == 0)
+        return Lept::STRINGIFY_OK; 
+
+    return writeFull(this->m_temp, data, len) ? Lept::STRINGIFY_OK : Lept::STRINGIFY_FILE_WRITE_FAILURE; 
 }
-/* parse strings and arrays */
-unsigned long Lept::Context::str2hex(int& ret)
+int Lept::ReplaceWriter::commit(void)
 {
-    unsigned long hex = 0;
+    if (this->flush() != Lept::STRINGIFY_OK)
+        return this->getStatus(); 
 
-    if (!IS_HEX(*this->getTxt()))
+    if (this->m_temp < 0)
     {
-        ret = Lept::PARSE_INVALID_UNICODE_HEX;
-        return 0;
+        /* all output matched, path is unchanged unless it goes on */
+        char extra; 
+        long got = readFull(this->m_original, &extra, 1); 
+        if (got < 0)
+            this->setStatus(Lept::STRINGIFY_FILE_WRITE_FAILURE); 
+        else if (got != 0)
+            this->setStatus(this->openTemp(this->m_same)); 
+        if (got <= 0)
+            return this->getStatus(); 
     }
-    hex += CH2HEX(*this->getTxt());
-    this->txtIncre();
+    if (this->getStatus() != Lept::STRINGIFY_OK)
+        return this->getStatus(); 
+
+    /* the data must be on disk before the rename makes it visible */
+    int fd = this->m_temp; 
+    this->m_temp = -1; 
+    if (LEPT_FSYNC(fd) != 0)
+        this->setStatus(Lept::STRINGIFY_FILE_WRITE_FAILURE); 
+    if (LEPT_CLOSE(fd) != 0)
+        this->setStatus(Lept::STRINGIFY_FILE_WRITE_FAILURE); 
+    if (this->getStatus() == Lept::STRINGIFY_OK && LEPT_RENAME(this->m_tempPath.c_str(), this->m_path.c_str()) != 0)
+        this->setStatus(Lept::STRINGIFY_FILE_WRITE_FAILURE); 
+    if (this->getStatus() != Lept::STRINGIFY_OK)
+        return this->getStatus(); 
+    this->m_tempPath.clear(); 
+    this->m_changed = true; 
+
+#ifndef _WIN32
+    /* and the rename itself survives a crash once the directory is synced */
+    size_t slash = this->m_path.rfind('/'); 
+    std::string dir = (slash == std::string::npos) ? std::string(".") : this->m_path.substr(0, slash + 1); 
+    int dirFd = ::open(dir.c_str(), O_RDONLY); 
+    if (dirFd >= 0)
+    {
+        LEPT_FSYNC(dirFd); 
+        LEPT_CLOSE(dirFd); 
+    }
+#endif
 
-    for (unsigned int index = 1; index < 4; ++index)
+    return Lept::STRINGIFY_OK; 
+}
+#endif
+
+
+/* ------- Lept::Cursor -------- */
+#if 1
+/* steps of a resumable stringification */
+enum
+{
+    CURSOR_VALUE = 0, /* write m_value */
+    CURSOR_ELEMENT_BREAK, /* line break before the current element */
+    CURSOR_KEY, /* key of the current member */
+    CURSOR_COLON, 
+    CURSOR_AFTER_VALUE, /* comma, or close the container */
+    CURSOR_CLOSE_BREAK, /* line break before the closing bracket */
+    CURSOR_CLOSE, 
+    CURSOR_DONE
+};
+
+// Constructor; 
+Lept::Cursor::Cursor(const Lept::Format& fmt) :
+    m_fmt(&fmt), 
+    m_out(nullptr), 
+    m_space(0)
+{
+    this->reset(); 
+}
+// Destructor; 
+Lept::Cursor::~Cursor(void)
+{
+
+}
+
+/* get-Functions */
+bool Lept::Cursor::isDone(void) const
+{
+    return (this->m_step == CURSOR_DONE); 
+}
+
+/* set-Functions */
+void Lept::Cursor::reset(void)
+{
+    this->m_value = nullptr; 
+    this->m_depth = 0; 
+    this->m_step = CURSOR_VALUE; 
+    this->m_offset = 0; 
+    this->m_strIndex = 0; 
+    this->m_column = 0; 
+    this->m_inlineDepth = 0; 
+
+    return; 
+}
+
+/* copy what fits of the rest of piece, true once all of it is written */
+bool Lept::Cursor::emit(const char* piece, size_t len)
+{
+    size_t count = std::min(len - this->m_offset, this->m_space); 
+
+    memcpy(this->m_out, piece + this->m_offset, count); 
+    this->m_out += count; 
+    this->m_space -= count; 
+    this->m_offset += count; 
+    this->m_column += count; 
+    if (this->m_offset != len)
+        return false; 
+
+    this->m_offset = 0; 
+    return true; 
+}
+bool Lept::Cursor::emitBreakLine(int level)
+{
+    if (this->m_fmt->isCompact() || this->m_inlineDepth != 0)
+        return true; 
+
+    size_t len = this->m_fmt->breakLineSize(level); 
+    size_t newlineLen = len - (size_t)level * this->m_fmt->getIndentWidth(); 
+
+    /* generated in place, the format's indentation cache may be shorter than level */
+    for (; this->m_offset < newlineLen && this->m_space != 0; ++this->m_offset, --this->m_space)
+        *this->m_out++ = (newlineLen == 2 && this->m_offset == 0) ? '\r' : '\n'; 
+    if (this->m_offset >= newlineLen)
     {
-        if (!IS_HEX(*this->getTxt()))
+        size_t count = std::min(len - this->m_offset, this->m_space); 
+        memset(this->m_out, this->m_fmt->getIndentChar(), count); 
+        this->m_out += count; 
+        this->m_space -= count; 
+        this->m_offset += count; 
+    }
+    if (this->m_offset != len)
+        return false; 
+
+    this->m_offset = 0; 
+    this->m_column = (size_t)level * this->m_fmt->getIndentWidth(); 
+    return true; 
+}
+/* same bytes as Writer::writeString(), m_strIndex counts the quote as a source byte */
+bool Lept::Cursor::emitString(const std::string& str)
+{
+    static const char hexDigits[] = "0123456789ABCDEF"; 
+    const char* p = str.data(); 
+    size_t len = str.size(); 
+
+    if (this->m_strIndex == 0)
+    {
+        if (!this->emit("\"", 1))
+            return false; 
+        this->m_strIndex = 1; 
+    }
+    while (this->m_strIndex <= len)
+    {
+        size_t index = this->m_strIndex - 1; 
+        char esc = escapeOf((unsigned char)p[index]); 
+        if (esc == '\0')
         {
-            ret = Lept::PARSE_INVALID_UNICODE_HEX;
-            return 0;
+            /* run of unescaped bytes, copied as far as it fits */
+            size_t end = index; 
+            while (end < len && escapeOf((unsigned char)p[end]) == '\0')
+                ++end; 
+            size_t count = std::min(end - index, this->m_space); 
+            memcpy(this->m_out, p + index, count); 
+            this->m_out += count; 
+            this->m_space -= count; 
+            this->m_column += count; 
+            this->m_strIndex += count; 
+            if (count != end - index)
+                return false; 
+            continue; 
         }
 
-        hex *= 16;
-        hex += CH2HEX(*this->getTxt());
-        this->txtIncre();
+        unsigned char cur = (unsigned char)p[index]; 
+        char buffer[6] = { '\\', esc, '0', '0', hexDigits[cur >> 4], hexDigits[cur & 0xF] }; 
+        if (!this->emit(buffer, (esc == 'u') ? 6 : 2))
+            return false; 
+        ++this->m_strIndex; 
     }
+    if (!this->emit("\"", 1))
+        return false; 
 
-    return hex;
+    this->m_strIndex = 0; 
+    return true; 
 }
-int Lept::Context::parseHex(std::string* str, int& ret)
-{
-    EXPECT(this, 'u');
 
-    /* get code point */
-    unsigned long hex = this->str2hex(ret);
-    if (ret != Lept::PARSE_OK)
-        return 0;
+int Lept::Cursor::fill(const Lept::Value& root, char* buffer, size_t size, size_t& written)
+{
+    this->m_out = buffer; 
+    this->m_space = size; 
+    if (this->m_value == nullptr && this->m_step == CURSOR_VALUE)
+        this->m_value = &root; 
 
-    if (hex >= 0xD800 && hex <= 0xDBFF)
+    while (this->m_step != CURSOR_DONE)
     {
-        if (*this->getTxt() != '\\' || *(this->getTxt() + 1) != 'u')
+        Frame* top = (this->m_depth == 0) ? nullptr : &this->m_stack[this->m_depth - 1]; 
+        const Lept::Value* v = this->m_value; 
+        size_t len = 0; 
+        bool done = true; 
+
+        if (top != nullptr)
+            len = (top->value->getType() == Lept::Type::ARRAY) ? top->value->getArr()->size() : top->value->getObj()->size(); 
+
+        switch (this->m_step)
         {
-            ret = Lept::PARSE_INVALID_UNICODE_SURROGATE;
-            return 0;
+        case CURSOR_VALUE:
+            switch (v->getType())
+            {
+            case Lept::Type::NULLJSON: done = this->emit("null", 4); break; 
+            case Lept::Type::FALSE: done = this->emit("false", 5); break; 
+            case Lept::Type::TRUE: done = this->emit("true", 4); break; 
+            case Lept::Type::NUMBER:
+            {
+                /* regenerated on resumption, the same bytes come out */
+                char number[32]; 
+                int count = snprintf(number, sizeof(number), "%.17g", v->getNum()); 
+                done = this->emit(number, count); 
+                break; 
+            }
+            case Lept::Type::STRING: done = this->emitString(*v->getStr()); break; 
+            case Lept::Type::ARRAY:
+            case Lept::Type::OBJECT:
+                if (this->m_depth == LEPT_CURSOR_MAX_DEPTH)
+                {
+                    written = size - this->m_space; 
+                    return Lept::STRINGIFY_DEPTH_EXCEEDED; 
+                }
+                len = (v->getType() == Lept::Type::ARRAY) ? v->getArr()->size() : v->getObj()->size(); 
+                /* decided before the bracket goes out, a retry after a full buffer decides the same */
+                if (this->m_inlineDepth == 0 && fitsLine(*v, *this->m_fmt, this->m_column))
+                    this->m_inlineDepth = this->m_depth + 1; 
+                if (!(done = this->emit((v->getType() == Lept::Type::ARRAY) ? "[" : "{", 1)))
+                    break; 
+                this->m_stack[this->m_depth].value = v; 
+                this->m_stack[this->m_depth].index = 0; 
+                ++this->m_depth; 
+                this->m_step = (len != 0) ? CURSOR_ELEMENT_BREAK : CURSOR_CLOSE_BREAK; 
+                continue; 
+            }
+            if (done)
+                this->m_step = CURSOR_AFTER_VALUE; 
+            break; 
+        case CURSOR_ELEMENT_BREAK:
+            if (!(done = this->emitBreakLine(this->m_depth)))
+                break; 
+            if (top->value->getType() == Lept::Type::ARRAY)
+            {
+                this->m_value = top->value->getArr()->at(top->index); 
+                this->m_step = CURSOR_VALUE; 
+            }
+            else
+                this->m_step = CURSOR_KEY; 
+            break; 
+        case CURSOR_KEY:
+            if ((done = this->emitString(*top->value->getObj()->at(top->index)->key)))
+                this->m_step = CURSOR_COLON; 
+            break; 
+        case CURSOR_COLON:
+            if ((done = this->emit(":", 1)))
+            {
+                this->m_value = top->value->getObj()->at(top->index)->value; 
+                this->m_step = CURSOR_VALUE; 
+            }
+            break; 
+        case CURSOR_AFTER_VALUE:
+            if (top == nullptr)
+            {
+                this->m_step = CURSOR_DONE; 
+                break; 
+            }
+            if (top->index + 1 == len)
+            {
+                this->m_step = CURSOR_CLOSE_BREAK; 
+                break; 
+            }
+            if ((done = this->emit(",", 1)))
+            {
+                ++top->index; 
+                this->m_step = CURSOR_ELEMENT_BREAK; 
+            }
+            break; 
+        case CURSOR_CLOSE_BREAK:
+            if ((done = this->emitBreakLine(this->m_depth - 1)))
+                this->m_step = CURSOR_CLOSE; 
+            break; 
+        case CURSOR_CLOSE:
+            if ((done = this->emit((top->value->getType() == Lept::Type::ARRAY) ? "]" : "}", 1)))
+            {
+                if (this->m_inlineDepth == this->m_depth)
+                    this->m_inlineDepth = 0; 
+                --this->m_depth; 
+                this->m_step = CURSOR_AFTER_VALUE; 
+            }
+            break; 
         }
-        this->txtIncre(2);
 
-        unsigned long lowhex = this->str2hex(ret);
-        if (lowhex < 0xDC00 || lowhex > 0xDFFF)
+        if (!done)
         {
-            ret = Lept::PARSE_INVALID_UNICODE_SURROGATE;
-            return 0;
+            written = size; 
+            return Lept::STRINGIFY_NEED_MORE_SPACE; 
         }
-
-        hex = 0x10000 + (hex - 0xD800) * 0x400 + (lowhex - 0xDC00);
     }
 
-    assert(hex >= 0x0000 && hex <= 0x10FFFF);
+    written = size - this->m_space; 
+    return Lept::STRINGIFY_OK; 
+}
+#endif
 
-    /* get unicode */
-    if (hex < 0x0080) /* 0xxxxxxx */
-    {
-        str->push_back((uint8_t)hex);
-    }
-    else if (hex < 0x0800) /* 110xxxxx 10xxxxxx */
-    {
-        /* 0xC0 = 11000000 */
-        str->push_back(0xC0 | ((uint8_t)(hex >> 6) & 0xFF)); /* 0x80 = 10000000 */
-        str->push_back(0x80 | ((uint8_t)(hex) & 0x3F)); /* 0x3F = 00111111 */
-    }
-    else if (hex < 0x10000) /* 1110xxxx 10xxxxxx 10xxxxxx */
+
+/* ------- Lept::Value -------- */
+#if 1
+// Constructor; 
+Lept::Value::Value(Lept::Type type) :
+    m_type(type)
+{
+    switch (type)
     {
-        /* 0xE0 = 11100000 */
-        str->push_back(0xE0 | ((uint8_t)(hex >> 12) & 0xFF)); /* 0x80 = 10000000 */
-        str->push_back(0x80 | ((uint8_t)(hex >> 6) & 0x3F)); /* 0x3F = 00111111 */
-        str->push_back(0x80 | ((uint8_t)(hex) & 0x3F)); /* 0x3F = 00111111 */
+    case Lept::Type::STRING:
+        this->m_str = new std::string;
+        break; 
+    case Lept::Type::ARRAY:
+        this->m_arr = new std::vector<Lept::Value*>; 
+        break; 
+    case Lept::Type::OBJECT:
+        this->m_obj = new std::vector<Lept::Member*>; 
+        break; 
+    default:
+        this->m_num = 0.0; 
+        break; 
     }
-    else if (hex < 0x10FFFF) /* 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+}
+// Destructor; 
+Lept::Value::~Value(void)
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::DESTROY); 
+    Lept::Type type = this->getType(); 
+
+    switch (type)
     {
-        /* 0xF0 = 11110000 */
-        str->push_back(0xF0 | ((uint8_t)(hex >> 18) & 0xFF)); /* 0x80 = 10000000 */
-        str->push_back(0x80 | ((uint8_t)(hex >> 12) & 0x3F)); /* 0x3F = 00111111 */
-        str->push_back(0x80 | ((uint8_t)(hex >> 6) & 0x3F)); /* 0x3F = 00111111 */
-        str->push_back(0x80 | ((uint8_t)(hex) & 0x3F)); /* 0x3F = 00111111 */
+    case Lept::Type::STRING:
+        delete this->m_str; 
+        break; 
+    case Lept::Type::ARRAY:
+        int len; 
+        len = this->m_arr->size() - 1; 
+        for (; len >= 0; --len)
+            delete this->getArrElem(len); 
+        delete this->m_arr; 
+        break;
+    case Lept::Type::OBJECT:
+        len = this->m_obj->size() - 1;
+        for (; len >= 0; --len)
+        {
+            delete this->getObjElem(len)->key;
+            delete this->getObjElem(len)->value;
+            delete this->getObjElem(len);
+        }
+        delete this->m_obj;
+        break;
+    default:
+        break; 
     }
+}
 
-    return Lept::PARSE_OK;
+/* get-Functions */
+Lept::Type Lept::Value::getType(void) const
+{
+    return this->m_type;
 }
-int Lept::Context::parseString(std::string* str)
+bool Lept::Value::getBoolean(void) const
 {
-    EXPECT(this, '\"');
+    assert(this->getType() == Lept::Type::TRUE || this->getType() == Lept::Type::FALSE); 
 
-    /* validate string */
-    while (*this->getTxt() != '\"')
-    {
-        int ret; /* for unicode parsing */
+    return (this->getType() == Lept::Type::TRUE); 
+}
+double Lept::Value::getNum(void) const
+{
+    assert(this->getType() == Lept::Type::NUMBER); 
 
-        if (*this->getTxt() == '\0') /* this is rational because \0 is represented by \u0000 in JSON context */
-            return Lept::PARSE_MISSING_QUOTATION_MARK;
+    return this->m_num; 
+}
+std::string* Lept::Value::getStr(void) const
+{
+    assert(this->getType() == Lept::Type::STRING); 
 
-        if (*this->getTxt() == '\\')
-        { /* deal with escape characters */
-            this->txtIncre();
+    return this->m_str; 
+}
+std::vector<Lept::Value*>* Lept::Value::getArr(void) const
+{
+    assert(this->getType() == Lept::Type::ARRAY);
+
+    return this->m_arr;
+}
+Lept::Value* Lept::Value::getArrElem(void) const
+{
+    assert(this->getType() == Lept::Type::ARRAY);
+
+    return this->m_arr->at(this->m_arr->size() - 1);
+}
+Lept::Value* Lept::Value::getArrElem(unsigned int index) const
+{
+    assert(this->getType() == Lept::Type::ARRAY);
+
+    return this->m_arr->at(index);
+}
+std::vector<Lept::Member*>* Lept::Value::getObj(void) const
+{
+    assert(this->getType() == Lept::Type::OBJECT);
+
+    return this->m_obj;
+}
+Lept::Member* Lept::Value::getObjElem(void) const
+{
+    assert(this->getType() == Lept::Type::OBJECT);
+
+    return this->m_obj->at(this->m_obj->size() - 1);
+}
+Lept::Member* Lept::Value::getObjElem(unsigned int index) const
+{
+    assert(this->getType() == Lept::Type::OBJECT);
+
+    return this->m_obj->at(index);
+}
+
+/* set-Functions */
+void Lept::Value::setType(Lept::Type type)
+{
+    int len = 0;
+
+    {
+        /* dropping the old contents counts as destruction */
+        LEPT_ALLOC_SCOPE(Lept::AllocPhase::DESTROY); 
+        switch (this->m_type)
+        {
+        case Lept::Type::STRING:
+            delete this->m_str;
+            break; 
+        case Lept::Type::ARRAY:
+            len = this->m_arr->size() - 1;
+            for (; len >= 0; --len)
+                delete this->getArrElem(len);
+            delete this->m_arr; 
+            break; 
+        case Lept::Type::OBJECT:
+            len = this->m_obj->size() - 1;
+            for (; len >= 0; --len)
+            {
+                delete this->getObjElem(len)->key;
+                delete this->getObjElem(len)->value;
+                delete this->getObjElem(len);
+            }
+            delete this->m_obj;
+            break;
+        default:
+            break; 
+        }
+    }
+
+    this->m_type = type;
+    switch (type)
+    {
+    case Lept::Type::STRING:
+        this->m_str = new std::string; 
+        break; 
+    case Lept::Type::ARRAY:
+        this->m_arr = new std::vector<Lept::Value*>; 
+        break; 
+    case Lept::Type::OBJECT:
+        this->m_obj = new std::vector<Lept::Member*>; 
+        break; 
+    default:
+        this->m_num = 0.0; 
+        break; 
+    }
+
+    return; 
+}
+void Lept::Value::setNull(void)
+{
+    this->setType(Lept::Type::NULLJSON); 
+
+    return; 
+}
+void Lept::Value::setBoolean(bool bln)
+{
+    this->setType(bln ? Lept::Type::TRUE : Lept::Type::FALSE);
+
+    return;
+}
+void Lept::Value::setNum(double num)
+{
+    this->setType(Lept::Type::NUMBER);
+    this->m_num = num; 
+
+    return; 
+}
+void Lept::Value::setStrNew(void)
+{
+    assert(this->getType() == Lept::Type::STRING); 
+
+    this->m_str = new std::string; 
+
+    return; 
+}
+void Lept::Value::setStr(std::string* str)
+{
+    assert(this->getType() == Lept::Type::STRING);
+
+    if (this->m_str != str)
+    {
+        delete this->m_str; /* v owns str from now on */
+        this->m_str = str; 
+    }
+
+    return; 
+}
+void Lept::Value::setStr(std::string str)
+{
+    assert(this->getType() == Lept::Type::STRING);
+
+    *this->m_str = str;
+
+    return;
+}
+void Lept::Value::appendChar(char ch)
+{
+    assert(this->getType() == Lept::Type::STRING); 
+
+    this->m_str->push_back(ch); 
+
+    return; 
+}
+void Lept::Value::appendArrElem(Lept::Value &elem)
+{
+    assert(this->getType() == Lept::Type::ARRAY);
+
+    this->m_arr->push_back(&elem); 
+
+    return; 
+}
+void Lept::Value::appendObjElem(Lept::Member& elem)
+{
+    assert(this->getType() == Lept::Type::OBJECT);
+
+    this->m_obj->push_back(&elem);
+
+    return;
+}
+
+/* parse JSON context to tree context */
+int Lept::Value::parse(Lept::Context &c)
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::PARSE); 
+    int ret = Lept::PARSE_OK;
+
+    this->setType(Lept::Type::NULLJSON); // by default set NULL data; 
+    c.parseWs(); // skip the leading ws; 
+
+    if ((ret = c.parseValue(*this)) == Lept::PARSE_OK)
+    {
+        c.parseWs();
+        if (*c.getTxt() != '\0')
+        {
+            this->setType(Lept::Type::NULLJSON);
+            ret = Lept::PARSE_ROOT_NOT_SINGULAR;
+        }
+    }
+
+    return ret;
+}
+int Lept::Value::parse(const char* json)
+{
+    Lept::Context c(json); // create JSON context; 
+
+    return this->parse(c); 
+}
+int Lept::Value::parse(std::string json)
+{
+    char* str = new char[json.size() + 1]; 
+    strcpy(str, json.c_str()); 
+    Lept::Context c(str); 
+    int ret = this->parse(c); 
+    delete[] str; 
+
+    return ret; 
+}
+
+/* JSON stringifier components*/
+#if 1
+static size_t stringifySize(const Lept::Value& v, const Lept::Format& fmt, int level, size_t column)
+{
+    size_t size = 0, len = 0; 
+    size_t indent = (size_t)(level + 1) * fmt.getIndentWidth(); /* column of the elements */
+
+    if ((v.getType() == Lept::Type::ARRAY || v.getType() == Lept::Type::OBJECT) && fitsLine(v, fmt, column))
+        return compactSize(v, fmt.getMaxWidth()); 
+
+    switch (v.getType())
+    {
+    case Lept::Type::NULLJSON:
+    case Lept::Type::TRUE:
+        return 4; 
+    case Lept::Type::FALSE:
+        return 5; 
+    case Lept::Type::NUMBER:
+        return numberSize(v.getNum()); 
+    case Lept::Type::STRING:
+        return escapedSize(*v.getStr()); 
+    case Lept::Type::ARRAY:
+        len = v.getArr()->size(); 
+        for (size_t index = 0; index < len; ++index)
+            size += stringifySize(*v.getArr()->at(index), fmt, level + 1, indent); 
+        break; 
+    case Lept::Type::OBJECT:
+        len = v.getObj()->size(); 
+        for (size_t index = 0; index < len; ++index)
+        {
+            size_t keySize = escapedSize(*v.getObj()->at(index)->key) + 1; /* ':' */
+            size += keySize; 
+            size += stringifySize(*v.getObj()->at(index)->value, fmt, level + 1, indent + keySize); 
+        }
+        break; 
+    }
+
+    /* brackets, commas, a line break before each element and before the closing bracket */
+    size += 2 + len + fmt.breakLineSize(level); 
+    if (len != 0)
+        size += len * fmt.breakLineSize(level + 1) - 1; 
+
+    return size; 
+}
+size_t Lept::Value::stringifySize(const Lept::Format& fmt) const
+{
+    return ::stringifySize(*this, fmt, 0, 0); 
+}
+int Lept::Value::stringifyLiteral(Lept::Writer& w) const
+{
+    Lept::Type type = this->getType();
+    assert(type == Lept::Type::NULLJSON || this->getType() == Lept::Type::FALSE || this->getType() == Lept::Type::TRUE); 
+    
+    switch (type)
+    {
+    case Lept::Type::NULLJSON:
+        w.write("null", 4); 
+        break;
+    case Lept::Type::FALSE:
+        w.write("false", 5);
+        break;
+    case Lept::Type::TRUE:
+        w.write("true", 4);
+        break;
+    default:
+        break; 
+    }
+
+    return w.getStatus(); 
+}
+int Lept::Value::stringifyNumber(Lept::Writer& w) const
+{
+    assert(this->getType() == Lept::Type::NUMBER); 
+
+    char buffer[32]; 
+    int len = snprintf(buffer, sizeof(buffer), "%.17g", this->getNum());
+    w.write(buffer, len);
+
+    return w.getStatus(); 
+}
+int Lept::Value::stringifyString(Lept::Writer& w) const
+{
+    assert(this->getType() == Lept::Type::STRING);
+
+    w.writeString(*this->getStr()); 
+
+    return w.getStatus(); 
+}
+int Lept::Value::stringifyArray(Lept::Writer& w) const
+{
+    assert(this->getType() == Lept::Type::ARRAY);
+    int ret = Lept::STRINGIFY_OK; 
+
+    unsigned int len = this->getArr()->size();
+    bool isInline = (!w.isInline() && fitsLine(*this, w.getFormat(), w.getColumn())); 
+    if (isInline)
+        w.setInline(true); 
+    w.put('[');
+    w.levelUp();
+    if (len != 0) // beautifiy empty array; 
+        w.breakLine();
+
+    for (unsigned int index = 0; index < len; ++index)
+    {
+        ret = this->getArr()->at(index)->stringify(w);
+        if (ret != Lept::STRINGIFY_OK)
+            return ret;
+        if (index != len - 1)
+        {
+            w.put(',');
+            w.breakLine();
+        }
+    }
+    w.levelDown();
+    w.breakLine();
+    w.put(']');
+    if (isInline)
+        w.setInline(false); 
+
+    return w.getStatus();
+}
+int Lept::Value::stringifyObject(Lept::Writer& w) const
+{
+    assert(this->getType() == Lept::Type::OBJECT);
+    int ret = Lept::STRINGIFY_OK;
+
+    unsigned int len = this->getObj()->size();
+    bool isInline = (!w.isInline() && fitsLine(*this, w.getFormat(), w.getColumn())); 
+    if (isInline)
+        w.setInline(true); 
+    w.put('{');
+    w.levelUp();
+    if (len != 0) // beautifiy empty object; 
+        w.breakLine();
+
+    for (unsigned int index = 0; index < len; ++index)
+    {
+        w.writeString(*this->getObj()->at(index)->key); 
+        w.put(':');
+
+        ret = this->getObj()->at(index)->value->stringify(w);
+        if (ret != Lept::STRINGIFY_OK)
+            return ret;
+        if (index != len - 1)
+        {
+            w.put(',');
+            w.breakLine();
+        }
+    }
+    w.levelDown();
+    w.breakLine();
+    w.put('}');
+    if (isInline)
+        w.setInline(false); 
+
+    return w.getStatus();
+}
+int Lept::Value::stringify(Lept::Writer& w) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY);
+    Lept::Type type = this->getType();
+    int ret = Lept::STRINGIFY_OK;
+
+    switch (type)
+    {
+    case Lept::Type::NULLJSON:
+    case Lept::Type::FALSE:
+    case Lept::Type::TRUE:
+        ret = this->stringifyLiteral(w);
+        break;
+    case Lept::Type::NUMBER:
+        ret = this->stringifyNumber(w);
+        break;
+    case Lept::Type::STRING:
+        ret = this->stringifyString(w);
+        break;
+    case Lept::Type::ARRAY:
+        ret = this->stringifyArray(w);
+        break;
+    case Lept::Type::OBJECT:
+        ret = this->stringifyObject(w);
+        break;
+    }
+
+    return ret;
+}
+int Lept::Value::stringifyParallel(Lept::Writer& w, unsigned int threads) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+    Lept::Type type = this->getType(); 
+    size_t len = 0; 
+    if (type == Lept::Type::ARRAY)
+        len = this->getArr()->size(); 
+    else if (type == Lept::Type::OBJECT)
+        len = this->getObj()->size(); 
+
+    if (threads <= 1 || len < LEPT_PARALLEL_MIN_ELEMENTS || w.isInline() || fitsLine(*this, w.getFormat(), w.getColumn()))
+        return this->stringify(w); 
+
+    /* several chunks per thread to even out uneven elements, 
+     * at most window chunks are buffered ahead of the writer */
+    const size_t chunkLen = std::max<size_t>(256, len / (threads * 8)); 
+    const size_t chunkCount = (len + chunkLen - 1) / chunkLen; 
+    const size_t window = threads * 2; 
+
+    std::vector<std::string> slots(window); 
+    std::vector<int> slotStatus(window, Lept::STRINGIFY_OK); 
+    std::vector<char> slotDone(window, 0); 
+    size_t next = 0, written = 0; 
+    bool failed = false; 
+    std::mutex mtx; 
+    std::condition_variable cv; 
+
+    auto worker = [&](void) {
+        LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+        for (;;)
+        {
+            size_t chunk; 
+            {
+                std::unique_lock<std::mutex> lock(mtx); 
+                cv.wait(lock, [&](void) { return failed || next >= chunkCount || next < written + window; }); 
+                if (failed || next >= chunkCount)
+                    return; 
+                chunk = next++; 
+            }
+
+            std::string& out = slots[chunk % window]; 
+            out.clear(); 
+            int ret; 
+            {
+                /* elements sit one level below the root, the root's line break goes first */
+                Lept::StringWriter cw(out, w.getFormat()); 
+                cw.levelUp(); 
+                size_t end = std::min(len, (chunk + 1) * chunkLen); 
+                for (size_t index = chunk * chunkLen; index < end; ++index)
+                {
+                    cw.breakLine(); 
+                    if (type == Lept::Type::ARRAY)
+                        this->getArr()->at(index)->stringify(cw); 
+                    else
+                    {
+                        cw.writeString(*this->getObj()->at(index)->key); 
+                        cw.put(':'); 
+                        this->getObj()->at(index)->value->stringify(cw); 
+                    }
+                    if (index != len - 1)
+                        cw.put(','); 
+                }
+                ret = cw.flush(); 
+            }
+
+            std::unique_lock<std::mutex> lock(mtx); 
+            slotStatus[chunk % window] = ret; 
+            slotDone[chunk % window] = 1; 
+            cv.notify_all(); 
+        }
+    }; 
+
+    std::vector<std::thread> pool; 
+    for (unsigned int index = 0; index < threads; ++index)
+        pool.emplace_back(worker); 
+
+    w.put(type == Lept::Type::ARRAY ? '[' : '{'); 
+    std::vector<const std::string*> ready; 
+    int ret = Lept::STRINGIFY_OK; 
+    while (written < chunkCount && ret == Lept::STRINGIFY_OK)
+    {
+        /* collect every finished chunk in order and write them at once */
+        ready.clear(); 
+        {
+            std::unique_lock<std::mutex> lock(mtx); 
+            cv.wait(lock, [&](void) { return slotDone[written % window] != 0; }); 
+            for (size_t chunk = written; chunk < chunkCount && chunk < written + window && slotDone[chunk % window]; ++chunk)
+            {
+                if (slotStatus[chunk % window] != Lept::STRINGIFY_OK)
+                {
+                    ret = slotStatus[chunk % window]; 
+                    break; 
+                }
+                ready.push_back(&slots[chunk % window]); 
+            }
+        }
+        w.writeChunks(ready); 
+        if (ret == Lept::STRINGIFY_OK)
+            ret = w.getStatus(); 
+
+        std::unique_lock<std::mutex> lock(mtx); 
+        for (size_t index = 0; index < ready.size(); ++index)
+            slotDone[(written + index) % window] = 0; 
+        written += ready.size(); 
+        failed = (ret != Lept::STRINGIFY_OK); 
+        cv.notify_all(); 
+    }
+    for (size_t index = 0; index < pool.size(); ++index)
+        pool[index].join(); 
+    if (ret != Lept::STRINGIFY_OK)
+        return ret; 
+
+    w.breakLine(); 
+    w.put(type == Lept::Type::ARRAY ? ']' : '}'); 
+
+    return w.getStatus(); 
+}
+int Lept::Value::stringify(std::string& JSONCache, const Lept::Format& fmt, bool presize) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+    JSONCache.clear(); /* avoid rebundance when reusing JSONCache for another stringification */
+    Lept::StringWriter w(JSONCache, fmt); 
+    if (presize)
+        w.reserve(this->stringifySize(fmt)); 
+
+    int ret = this->stringify(w); 
+    if (ret == Lept::STRINGIFY_OK)
+        ret = w.flush(); 
+
+    /* stringification failure, leave no partial output */
+    if (ret != Lept::STRINGIFY_OK)
+        JSONCache.clear(); 
+
+    return ret; 
+}
+int Lept::Value::stringify(std::string& JSONCache) const
+{
+    static const Lept::Format defaultFormat; /* tab indented, LF line breaks */
+
+    return this->stringify(JSONCache, defaultFormat); 
+}
+int Lept::Value::stringify(char* buffer, size_t size, size_t& written, Lept::Cursor& cursor) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+    return cursor.fill(*this, buffer, size, written); 
+}
+int Lept::Value::stringifyFile(const char* path, const Lept::Format& fmt, bool presize) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+    Lept::FileWriter w(path, fmt); 
+    if (w.getStatus() != Lept::STRINGIFY_OK)
+        return w.getStatus(); 
+    if (presize)
+        w.reserve(this->stringifySize(fmt)); 
+
+    int ret = this->stringify(w); 
+    if (ret == Lept::STRINGIFY_OK)
+        ret = w.flush(); 
+
+    return ret; 
+}
+#endif
+#endif
+
+
+/* -------- Lept::Context -------- */
+#if 1
+/* append code point hex to str as UTF-8, shared by Lept::Context and Lept::Reader */
+static void appendUtf8(std::string* str, unsigned long hex)
+{
+    assert(hex <= 0x10FFFF);
+
+    if (hex < 0x0080) /* 0xxxxxxx */
+    {
+        str->push_back((uint8_t)hex);
+    }
+    else if (hex < 0x0800) /* 110xxxxx 10xxxxxx */
+    {
+        /* 0xC0 = 11000000 */
+        str->push_back(0xC0 | ((uint8_t)(hex >> 6) & 0xFF)); /* 0x80 = 10000000 */
+        str->push_back(0x80 | ((uint8_t)(hex) & 0x3F)); /* 0x3F = 00111111 */
+    }
+    else if (hex < 0x10000) /* 1110xxxx 10xxxxxx 10xxxxxx */
+    {
+        /* 0xE0 = 11100000 */
+        str->push_back(0xE0 | ((uint8_t)(hex >> 12) & 0xFF)); /* 0x80 = 10000000 */
+        str->push_back(0x80 | ((uint8_t)(hex >> 6) & 0x3F)); /* 0x3F = 00111111 */
+        str->push_back(0x80 | ((uint8_t)(hex) & 0x3F)); /* 0x3F = 00111111 */
+    }
+    else /* 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    {
+        /* 0xF0 = 11110000 */
+        str->push_back(0xF0 | ((uint8_t)(hex >> 18) & 0xFF)); /* 0x80 = 10000000 */
+        str->push_back(0x80 | ((uint8_t)(hex >> 12) & 0x3F)); /* 0x3F = 00111111 */
+        str->push_back(0x80 | ((uint8_t)(hex >> 6) & 0x3F)); /* 0x3F = 00111111 */
+        str->push_back(0x80 | ((uint8_t)(hex) & 0x3F)); /* 0x3F = 00111111 */
+    }
+
+    return;
+}
+
+/* counters of a Context built with LEPT_CONTEXT_STATS, nothing at all otherwise */
+#ifdef LEPT_CONTEXT_STATS
+static inline unsigned long long contextCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+class Lept::Context::Nesting
+{
+private:
+    Lept::Context& m_c; 
+
+public:
+    // Constructor; 
+    Nesting(Lept::Context& c) :
+        m_c(c)
+    {
+        if (++this->m_c.m_depth > this->m_c.m_stats.maxDepth)
+            this->m_c.m_stats.maxDepth = this->m_c.m_depth; 
+    }
+    // Destructor; 
+    ~Nesting(void)
+    {
+        --this->m_c.m_depth; 
+    }
+};
+#define CONTEXT_COUNT(c, field, n) ((c)->m_stats.field += (n))
+#define CONTEXT_NESTING(c) Lept::Context::Nesting nesting(*(c))
+/* bytes and cycles from here to CONTEXT_SPAN_END() */
+#define CONTEXT_SPAN_BEGIN(c) \
+    const char* spanTxt = (c)->getTxt(); \
+    unsigned long long spanCycles = contextCycles()
+#define CONTEXT_SPAN_END(c, bytes, cycles) \
+    do {\
+        (c)->m_stats.cycles += contextCycles() - spanCycles; \
+        (c)->m_stats.bytes += (c)->getTxt() - spanTxt; \
+    } while (0)
+#else
+#define CONTEXT_COUNT(c, field, n)
+#define CONTEXT_NESTING(c)
+#define CONTEXT_SPAN_BEGIN(c)
+#define CONTEXT_SPAN_END(c, bytes, cycles)
+#endif
+
+// Constructor; 
+Lept::Context::Context(const char* txt) :
+    m_txt(txt)
+{
+#ifdef LEPT_CONTEXT_STATS
+    this->resetStats(); 
+#endif
+}
+// Destructor; 
+Lept::Context::~Context(void)
+{
+
+}
+
+/* get-Functions */
+const char* Lept::Context::getTxt(void) const
+{
+    return this->m_txt;
+}
+#ifdef LEPT_CONTEXT_STATS
+const Lept::ContextStats& Lept::Context::getStats(void) const
+{
+    return this->m_stats; 
+}
+#endif
+
+/* set-Functions */
+void Lept::Context::setTxt(const char* txt)
+{
+    this->m_txt = txt;
+
+    return;
+}
+void Lept::Context::txtIncre(unsigned int inc)
+{
+    this->setTxt(this->getTxt() + inc);
+
+    return;
+}
+#ifdef LEPT_CONTEXT_STATS
+void Lept::Context::resetStats(void)
+{
+    this->m_stats = Lept::ContextStats(); 
+    this->m_depth = 0; 
+
+    return; 
+}
+#endif
+
+/* JSON parser components */
+#if 1
+/* parse single value */
+void Lept::Context::parseWs(void)
+{
+    CONTEXT_SPAN_BEGIN(this); 
+    // cursor;
+    const char* p = this->getTxt();
+    // skip ws; 
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        ++p;
+    // move cursor to the first non-ws char; 
+    this->setTxt(p);
+    CONTEXT_SPAN_END(this, wsBytes, wsCycles); 
+
+    return;
+}
+int Lept::Context::parseLiteral(Lept::Value& v, const char* stdtxt, Lept::Type type)
+{
+    EXPECT(this, stdtxt[0]);
+    unsigned int count = 1;
+    while (stdtxt[count] != '\0')
+    {
+        if (this->getTxt()[count - 1] != stdtxt[count])
+            return Lept::PARSE_INVALID_VALUE;
+        ++count;
+    }
+    this->txtIncre(count - 1);
+    CONTEXT_COUNT(this, literalBytes, count); 
+    v.setType(type);
+
+    return Lept::PARSE_OK;
+}
+int Lept::Context::parseNumber(Lept::Value& v)
+{
+    CONTEXT_SPAN_BEGIN(this); 
+    const char* end = this->getTxt();
+    /* validate legal number */
+
+    if (*end == '-')
+        end += 1;
+
+    if (!IS_DIGIT(*end))
+        return Lept::PARSE_INVALID_VALUE;
+    else if (IS_DIGIT_NONZERO(*end))
+    {
+        do
+        {
+            end += 1;
+        } while (IS_DIGIT(*end));
+    }
+    else
+        end += 1;
+
+    if (*end == '.')
+    {
+        if (!IS_DIGIT(*(end + 1)))
+            return Lept::PARSE_INVALID_VALUE;
+        do
+        {
+            end += 1;
+        } while (IS_DIGIT(*end));
+    }
+
+    if (*end == 'e' || *end == 'E')
+    {
+        end += 1;
+        if (*end == '+' || *end == '-')
+            end += 1;
+        if (!IS_DIGIT(*end))
+            return Lept::PARSE_INVALID_VALUE;
+        while (IS_DIGIT(*end))
+            end += 1;
+    }
+
+    errno = 0;
+    v.setType(Lept::Type::NUMBER); /* set type to make setNum available */
+    v.setNum(strtod(this->getTxt(), nullptr));
+    this->setTxt(end);
+    CONTEXT_SPAN_END(this, numberBytes, numberCycles); 
+
+    /* overflow detection */
+    if (errno = ERANGE && (v.getNum() == HUGE_VAL || v.getNum() == -HUGE_VAL))
+    {
+        v.setType(Lept::Type::NULLJSON);
+        return Lept::PARSE_NUMBER_OVERFLOW;
+    }
+    return Lept::PARSE_OK;
+}
+/* parse strings and arrays */
+unsigned long Lept::Context::str2hex(int& ret)
+{
+    unsigned long hex = 0;
+
+    if (!IS_HEX(*this->getTxt()))
+    {
+        ret = Lept::PARSE_INVALID_UNICODE_HEX;
+        return 0;
+    }
+    hex += CH2HEX(*this->getTxt());
+    this->txtIncre();
+
+    for (unsigned int index = 1; index < 4; ++index)
+    {
+        if (!IS_HEX(*this->getTxt()))
+        {
+            ret = Lept::PARSE_INVALID_UNICODE_HEX;
+            return 0;
+        }
+
+        hex *= 16;
+        hex += CH2HEX(*this->getTxt());
+        this->txtIncre();
+    }
+
+    return hex;
+}
+int Lept::Context::parseHex(std::string* str, int& ret)
+{
+    EXPECT(this, 'u');
+
+    /* get code point */
+    unsigned long hex = this->str2hex(ret);
+    if (ret != Lept::PARSE_OK)
+        return 0;
+
+    if (hex >= 0xD800 && hex <= 0xDBFF)
+    {
+        if (*this->getTxt() != '\\' || *(this->getTxt() + 1) != 'u')
+        {
+            ret = Lept::PARSE_INVALID_UNICODE_SURROGATE;
+            return 0;
+        }
+        this->txtIncre(2);
+        CONTEXT_COUNT(this, escapes, 1); 
+        CONTEXT_COUNT(this, unicodeEscapes, 1); 
+
+        unsigned long lowhex = this->str2hex(ret);
+        if (lowhex < 0xDC00 || lowhex > 0xDFFF)
+        {
+            ret = Lept::PARSE_INVALID_UNICODE_SURROGATE;
+            return 0;
+        }
+
+        hex = 0x10000 + (hex - 0xD800) * 0x400 + (lowhex - 0xDC00);
+    }
+
+    assert(hex >= 0x0000 && hex <= 0x10FFFF);
+
+    appendUtf8(str, hex);
+
+    return Lept::PARSE_OK;
+}
+int Lept::Context::parseString(std::string* str)
+{
+    EXPECT(this, '\"');
+
+    /* validate string */
+    while (*this->getTxt() != '\"')
+    {
+        int ret; /* for unicode parsing */
+
+        if (*this->getTxt() == '\0') /* this is rational because \0 is represented by \u0000 in JSON context */
+            return Lept::PARSE_MISSING_QUOTATION_MARK;
+
+        if (*this->getTxt() == '\\')
+        { /* deal with escape characters */
+            this->txtIncre();
+            CONTEXT_COUNT(this, escapes, 1); 
+
+            switch (*this->getTxt())
+            {
+            case '\"':
+            case '/':
+            case '\\':
+                str->push_back(*this->getTxt());
+                this->txtIncre();
+                break;
+            case 'b':
+                str->push_back('\b');
+                this->txtIncre();
+                break;
+            case 'f':
+                str->push_back('\f');
+                this->txtIncre();
+                break;
+            case 'n':
+                str->push_back('\n');
+                this->txtIncre();
+                break;
+            case 'r':
+                str->push_back('\r');
+                this->txtIncre();
+                break;
+            case 't':
+                str->push_back('\t');
+                this->txtIncre();
+                break;
+            case 'u': /* Unicode UTF-8 */
+                CONTEXT_COUNT(this, unicodeEscapes, 1); 
+                ret = Lept::PARSE_OK;
+                this->parseHex(str, ret);
+                if (ret != Lept::PARSE_OK)
+                    return ret;
+                break;
+            default:
+                return Lept::PARSE_INVALID_STRING_ESCAPE;
+            }
+        }
+        else if ((unsigned char)*this->getTxt() >= 0x20) /* need NOT check " and \ here, 'cuz they've been blocked by if and while */
+        { /* now for unescaped characters */
+            str->push_back(*this->getTxt());
+            this->txtIncre();
+        }
+        else
+            return Lept::PARSE_INVALID_STRING_CHAR;
+    }
+    this->txtIncre();
+
+    return Lept::PARSE_OK;
+}
+int Lept::Context::parseString(Lept::Value& v)
+{
+    int ret = Lept::PARSE_OK;
+
+    /* straight into the string of v, setType() has allocated it */
+    v.setType(Lept::Type::STRING);
+    CONTEXT_SPAN_BEGIN(this); 
+    ret = this->parseString(v.getStr()); 
+    CONTEXT_SPAN_END(this, stringBytes, stringCycles); 
+    if (ret != Lept::PARSE_OK)
+        v.setType(Lept::Type::NULLJSON);
+
+    return ret;
+}
+int Lept::Context::parseArray(Lept::Value& v)
+{
+    EXPECT(this, '[');
+    CONTEXT_NESTING(this); 
+
+    Lept::Value* cache; 
+    int ret = Lept::PARSE_OK; 
+    v.setType(Lept::Type::ARRAY); 
+    this->parseWs(); 
+
+    while (*this->getTxt() != ']')
+    {
+        cache = new Lept::Value; 
+        v.appendArrElem(*cache); /* freed with v on errors */
+        ret = this->parseValue(*cache);
+        if (ret != Lept::PARSE_OK)
+        {
+            v.setType(Lept::Type::NULLJSON);
+            return ret;
+        }
+
+        this->parseWs(); 
+        if (*this->getTxt() == ']')
+            continue; 
+        else if (*this->getTxt() == ',')
+        {
+            this->txtIncre();
+            this->parseWs();
+        }
+        else
+        {
+            v.setType(Lept::Type::NULLJSON);
+            return Lept::PARSE_MISSING_COMMA_OR_BRACKET;
+        }
+    }
+    this->txtIncre(); 
+
+    return ret; 
+}
+/* parse objects */
+int Lept::Context::parseObject(Lept::Value& v)
+{
+    EXPECT(this, '{');
+    CONTEXT_NESTING(this); 
+
+    Lept::Member* cache;
+    std::string* key; 
+    int ret = Lept::PARSE_OK;
+    v.setType(Lept::Type::OBJECT);
+    this->parseWs();
+
+    while (*this->getTxt() != '}')
+    {
+        if (*this->getTxt() != '\"')
+        {
+            v.setType(Lept::Type::NULLJSON);
+            return Lept::PARSE_MISSING_KEY;
+        }
+        key = new std::string;
+        CONTEXT_SPAN_BEGIN(this); 
+        ret = this->parseString(key);
+        CONTEXT_SPAN_END(this, stringBytes, stringCycles); 
+        if (ret != Lept::PARSE_OK)
+        {
+            delete key;
+            v.setType(Lept::Type::NULLJSON);
+            return ret;
+        }
+        /* the member joins v before its value is parsed, and is freed with v on errors */
+        cache = new Lept::Member;
+        cache->key = key; 
+        cache->value = new Lept::Value;
+        v.appendObjElem(*cache);
+
+        this->parseWs(); 
+        if (*this->getTxt() != ':')
+        {
+            v.setType(Lept::Type::NULLJSON);
+            return Lept::PARSE_MISSING_COLON;
+        }
+        this->txtIncre(); 
+        this->parseWs();
+
+        ret = this->parseValue(*cache->value);
+        if (ret != Lept::PARSE_OK)
+        {
+            v.setType(Lept::Type::NULLJSON);
+            return ret;
+        }
+
+        this->parseWs();
+        if (*this->getTxt() == '}')
+            continue;
+        else if (*this->getTxt() == ',')
+        {
+            this->txtIncre();
+            this->parseWs();
+        }
+        else
+        {
+            v.setType(Lept::Type::NULLJSON);
+            return Lept::PARSE_MISSING_COMMA_OR_BRACE;
+        }
+    }
+    this->txtIncre();
+
+    return ret;
+}
+/* parse JSON values */
+int Lept::Context::parseValue(Lept::Value& v)
+{
+    char txt = *this->getTxt();
+
+    switch (txt)
+    {
+    case 'n': // NULL; 
+        return this->parseLiteral(v, "null", Lept::Type::NULLJSON);
+    case 'f': // FALSE; 
+        return this->parseLiteral(v, "false", Lept::Type::FALSE);
+    case 't': // TRUE; 
+        return this->parseLiteral(v, "true", Lept::Type::TRUE);
+    default: // numbers or invalid JSON context; 
+        return this->parseNumber(v);
+    case '\"': // strings; 
+        return this->parseString(v);
+    case '[': // arrays; 
+        return this->parseArray(v);
+    case '{': // objects; 
+        return this->parseObject(v); 
+    case '\0': // reach the end of JSON context and have read nothing;
+        return Lept::PARSE_EXPECT_VALUE;
+    }
+}
+#endif
+#endif
+
+/* -------- Lept::DocumentStream -------- */
+#if 1
+// Constructor; 
+Lept::DocumentStream::DocumentStream(const char* json) :
+    m_json(json),
+    m_context(json),
+    m_begin(0),
+    m_end(0),
+    m_status(Lept::PARSE_OK)
+{
+
+}
+// Destructor; 
+Lept::DocumentStream::~DocumentStream(void)
+{
+
+}
+
+/* get-Functions */
+int Lept::DocumentStream::getStatus(void) const
+{
+    return this->m_status;
+}
+size_t Lept::DocumentStream::getBegin(void) const
+{
+    return this->m_begin;
+}
+size_t Lept::DocumentStream::getEnd(void) const
+{
+    return this->m_end;
+}
+
+bool Lept::DocumentStream::next(Lept::Value& v)
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::PARSE);
+    if (this->m_status != Lept::PARSE_OK)
+        return false;
+
+    v.setType(Lept::Type::NULLJSON);
+    this->m_context.parseWs();
+    if (*this->m_context.getTxt() == '\0')
+        return false;
+
+    this->m_begin = this->m_context.getTxt() - this->m_json;
+    this->m_status = this->m_context.parseValue(v);
+    this->m_end = this->m_context.getTxt() - this->m_json;
+    char next = this->m_json[this->m_end];
+    if (this->m_status == Lept::PARSE_OK && next != ' ' && next != '\t' && next != '\n' && next != '\r' && next != '\0')
+        this->m_status = Lept::PARSE_ROOT_NOT_SINGULAR; /* truefalse, 1-2, {}1: not two documents */
+    if (this->m_status != Lept::PARSE_OK)
+    {
+        v.setType(Lept::Type::NULLJSON);
+        return false;
+    }
+
+    return true;
+}
+bool Lept::DocumentStream::resync(void)
+{
+    const char* line = strchr(this->m_json + this->m_begin, '\n');
+    if (line == nullptr)
+    {
+        this->m_context.setTxt(this->m_json + this->m_begin + strlen(this->m_json + this->m_begin));
+        return false;
+    }
+
+    this->m_context.setTxt(line + 1);
+    this->m_status = Lept::PARSE_OK;
+
+    return true;
+}
+#endif
+
+
+/* -------- Lept::Handler -------- */
+#if 1
+// Destructor; 
+Lept::Handler::~Handler(void)
+{
+
+}
+#endif
+
+
+/* -------- Lept::Reader -------- */
+#if 1
+/* what the grammar expects between tokens */
+enum
+{
+    READER_VALUE = 0, /* root, after ',' in an array or after ':' */
+    READER_VALUE_OR_CLOSE, /* after '[' */
+    READER_KEY, /* after ',' in an object */
+    READER_KEY_OR_CLOSE, /* after '{' */
+    READER_COLON, /* after a key */
+    READER_COMMA_OR_CLOSE, /* after an element */
+    READER_END /* after the root value */
+};
+
+/* token being read, kept across feed() calls */
+enum
+{
+    TOKEN_NONE = 0,
+    TOKEN_LITERAL,
+    TOKEN_NUMBER,
+    TOKEN_STRING
+};
+
+/* positions inside numbers, named after the last char read */
+enum
+{
+    NUMBER_SIGN = 0, /* '-' */
+    NUMBER_ZERO, /* leading '0' */
+    NUMBER_INT, /* digits of the integer part */
+    NUMBER_DOT, /* '.' */
+    NUMBER_FRAC, /* digits of the fraction */
+    NUMBER_EXP, /* 'e' or 'E' */
+    NUMBER_EXP_SIGN, /* sign of the exponent */
+    NUMBER_EXP_DIGIT /* digits of the exponent */
+};
+
+/* positions inside strings */
+enum
+{
+    STRING_CHAR = 0, /* plain chars */
+    STRING_ESCAPE, /* after '\\' */
+    STRING_HEX, /* hex digits of \uxxxx */
+    STRING_LOW_BACKSLASH, /* '\\' of the low surrogate */
+    STRING_LOW_U, /* 'u' of the low surrogate */
+    STRING_LOW_HEX /* hex digits of the low surrogate */
+};
+
+// Constructor; 
+Lept::Reader::Reader(Lept::Handler& handler) :
+    m_handler(&handler)
+{
+    this->reset();
+}
+// Destructor; 
+Lept::Reader::~Reader(void)
+{
+
+}
+
+/* get-Functions */
+int Lept::Reader::getStatus(void) const
+{
+    return this->m_status;
+}
+size_t Lept::Reader::getOffset(void) const
+{
+    return this->m_offset;
+}
+int Lept::Reader::getDepth(void) const
+{
+    return (int)this->m_stack.size();
+}
+
+/* set-Functions */
+void Lept::Reader::reset(void)
+{
+    this->m_stack.clear();
+    this->m_state = READER_VALUE;
+    this->m_token = TOKEN_NONE;
+    this->m_sub = 0;
+    this->m_count = 0;
+    this->m_isKey = false;
+    this->m_literal = nullptr;
+    this->m_hex = 0;
+    this->m_high = 0;
+    this->m_buffer.clear();
+    this->m_status = Lept::PARSE_OK;
+    this->m_offset = 0;
+
+    return;
+}
+
+/* JSON reader components */
+#if 1
+/* first char of a value, which is consumed */
+int Lept::Reader::startValue(char ch)
+{
+    bool ok = true;
+
+    switch (ch)
+    {
+    case 'n':
+        this->m_literal = "null";
+        break;
+    case 't':
+        this->m_literal = "true";
+        break;
+    case 'f':
+        this->m_literal = "false";
+        break;
+    case '\"':
+        this->m_token = TOKEN_STRING;
+        this->m_sub = STRING_CHAR;
+        this->m_isKey = false;
+        this->m_buffer.clear();
+        return Lept::PARSE_OK;
+    case '[':
+        this->m_stack.push_back('[');
+        this->m_state = READER_VALUE_OR_CLOSE;
+        ok = this->m_handler->onStartArray();
+        return ok ? Lept::PARSE_OK : Lept::PARSE_HANDLER_ABORTED;
+    case '{':
+        this->m_stack.push_back('{');
+        this->m_state = READER_KEY_OR_CLOSE;
+        ok = this->m_handler->onStartObject();
+        return ok ? Lept::PARSE_OK : Lept::PARSE_HANDLER_ABORTED;
+    case '-':
+        this->m_sub = NUMBER_SIGN;
+        break;
+    case '0':
+        this->m_sub = NUMBER_ZERO;
+        break;
+    default:
+        if (!IS_DIGIT_NONZERO(ch))
+            return Lept::PARSE_INVALID_VALUE;
+        this->m_sub = NUMBER_INT;
+        break;
+    }
+
+    if (this->m_literal != nullptr)
+    {
+        this->m_token = TOKEN_LITERAL;
+        this->m_sub = 1;
+    }
+    else
+    {
+        this->m_token = TOKEN_NUMBER;
+        this->m_buffer.assign(1, ch);
+    }
+
+    return Lept::PARSE_OK;
+}
+/* a value is complete */
+int Lept::Reader::endValue(void)
+{
+    this->m_token = TOKEN_NONE;
+    this->m_state = this->m_stack.empty() ? READER_END : READER_COMMA_OR_CLOSE;
+
+    return Lept::PARSE_OK;
+}
+/* ch closes the innermost container */
+int Lept::Reader::closeContainer(char ch)
+{
+    bool ok;
+
+    this->m_stack.pop_back();
+    ok = (ch == ']') ? this->m_handler->onEndArray() : this->m_handler->onEndObject();
+    this->endValue();
+
+    return ok ? Lept::PARSE_OK : Lept::PARSE_HANDLER_ABORTED;
+}
+const char* Lept::Reader::readLiteral(const char* p, const char* end)
+{
+    while (p < end && this->m_literal[this->m_sub] != '\0')
+    {
+        if (*p != this->m_literal[this->m_sub])
+        {
+            this->m_status = Lept::PARSE_INVALID_VALUE;
+            return p;
+        }
+        ++p;
+        ++this->m_sub;
+    }
+
+    if (this->m_literal[this->m_sub] == '\0')
+    {
+        bool ok = (this->m_literal[0] == 'n') ? this->m_handler->onNull() : this->m_handler->onBoolean(this->m_literal[0] == 't');
+        this->m_literal = nullptr;
+        this->endValue();
+        if (!ok)
+            this->m_status = Lept::PARSE_HANDLER_ABORTED;
+    }
+
+    return p;
+}
+const char* Lept::Reader::readNumber(const char* p, const char* end)
+{
+    for (; p < end; ++p)
+    {
+        char ch = *p;
+        int next = -1; /* stays -1 where ch cannot continue the number */
+
+        switch (this->m_sub)
+        {
+        case NUMBER_SIGN:
+            if (IS_DIGIT(ch))
+                next = (ch == '0') ? NUMBER_ZERO : NUMBER_INT;
+            break;
+        case NUMBER_INT:
+            if (IS_DIGIT(ch))
+                next = NUMBER_INT;
+            /* fall through */
+        case NUMBER_ZERO:
+            if (ch == '.')
+                next = NUMBER_DOT;
+            else if (ch == 'e' || ch == 'E')
+                next = NUMBER_EXP;
+            break;
+        case NUMBER_DOT:
+        case NUMBER_FRAC:
+            if (IS_DIGIT(ch))
+                next = NUMBER_FRAC;
+            else if (this->m_sub == NUMBER_FRAC && (ch == 'e' || ch == 'E'))
+                next = NUMBER_EXP;
+            break;
+        case NUMBER_EXP:
+            if (ch == '+' || ch == '-')
+                next = NUMBER_EXP_SIGN;
+            else if (IS_DIGIT(ch))
+                next = NUMBER_EXP_DIGIT;
+            break;
+        case NUMBER_EXP_SIGN:
+        case NUMBER_EXP_DIGIT:
+            if (IS_DIGIT(ch))
+                next = NUMBER_EXP_DIGIT;
+            break;
+        }
+
+        if (next < 0)
+        {
+            /* ch belongs to what follows the number, if the number may end here */
+            this->m_status = this->endNumber();
+            return p;
+        }
+        this->m_sub = next;
+        this->m_buffer.push_back(ch);
+    }
+
+    return p;
+}
+int Lept::Reader::endNumber(void)
+{
+    if (this->m_sub != NUMBER_ZERO && this->m_sub != NUMBER_INT && this->m_sub != NUMBER_FRAC && this->m_sub != NUMBER_EXP_DIGIT)
+        return Lept::PARSE_INVALID_VALUE;
+
+    errno = 0;
+    double num = strtod(this->m_buffer.c_str(), nullptr);
+    if (errno == ERANGE && (num == HUGE_VAL || num == -HUGE_VAL))
+        return Lept::PARSE_NUMBER_OVERFLOW;
+
+    bool ok = this->m_handler->onNumber(num, this->m_buffer.data(), this->m_buffer.size());
+    this->endValue();
+
+    return ok ? Lept::PARSE_OK : Lept::PARSE_HANDLER_ABORTED;
+}
+const char* Lept::Reader::readString(const char* p, const char* end)
+{
+    while (p < end)
+    {
+        char ch = *p;
+
+        switch (this->m_sub)
+        {
+        case STRING_CHAR:
+        {
+            /* copy the run of plain chars at once */
+            const char* run = p;
+            while (p < end && *p != '\"' && *p != '\\' && (unsigned char)*p >= 0x20)
+                ++p;
+            this->m_buffer.append(run, p - run);
+            if (p == end)
+                return p;
+
+            if (*p == '\"')
+            {
+                this->m_status = this->endString();
+                return (this->m_status == Lept::PARSE_OK) ? p + 1 : p;
+            }
+            if (*p != '\\')
+            {
+                this->m_status = Lept::PARSE_INVALID_STRING_CHAR;
+                return p;
+            }
+            this->m_sub = STRING_ESCAPE;
+            break;
+        }
+        case STRING_ESCAPE:
+            switch (ch)
+            {
+            case '\"':
+            case '/':
+            case '\\':
+                this->m_buffer.push_back(ch);
+                break;
+            case 'b':
+                this->m_buffer.push_back('\b');
+                break;
+            case 'f':
+                this->m_buffer.push_back('\f');
+                break;
+            case 'n':
+                this->m_buffer.push_back('\n');
+                break;
+            case 'r':
+                this->m_buffer.push_back('\r');
+                break;
+            case 't':
+                this->m_buffer.push_back('\t');
+                break;
+            case 'u':
+                this->m_hex = 0;
+                this->m_count = 0;
+                this->m_sub = STRING_HEX;
+                ++p;
+                continue;
+            default:
+                this->m_status = Lept::PARSE_INVALID_STRING_ESCAPE;
+                return p;
+            }
+            this->m_sub = STRING_CHAR;
+            break;
+        case STRING_HEX:
+        case STRING_LOW_HEX:
+            if (!IS_HEX(ch))
+            {
+                this->m_status = (this->m_sub == STRING_HEX) ? Lept::PARSE_INVALID_UNICODE_HEX : Lept::PARSE_INVALID_UNICODE_SURROGATE;
+                return p;
+            }
+            this->m_hex = this->m_hex * 16 + CH2HEX(ch);
+            if (++this->m_count < 4)
+                break;
+
+            if (this->m_sub == STRING_HEX && this->m_hex >= 0xD800 && this->m_hex <= 0xDBFF)
+            {
+                this->m_high = this->m_hex;
+                this->m_sub = STRING_LOW_BACKSLASH;
+                break;
+            }
+            if (this->m_sub == STRING_HEX && this->m_hex >= 0xDC00 && this->m_hex <= 0xDFFF)
+            { /* low surrogate without a high one */
+                this->m_status = Lept::PARSE_INVALID_UNICODE_SURROGATE;
+                return p;
+            }
+            if (this->m_sub == STRING_LOW_HEX)
+            {
+                if (this->m_hex < 0xDC00 || this->m_hex > 0xDFFF)
+                {
+                    this->m_status = Lept::PARSE_INVALID_UNICODE_SURROGATE;
+                    return p;
+                }
+                this->m_hex = 0x10000 + (this->m_high - 0xD800) * 0x400 + (this->m_hex - 0xDC00);
+            }
+            appendUtf8(&this->m_buffer, this->m_hex);
+            this->m_sub = STRING_CHAR;
+            break;
+        case STRING_LOW_BACKSLASH:
+        case STRING_LOW_U:
+            if (ch != ((this->m_sub == STRING_LOW_BACKSLASH) ? '\\' : 'u'))
+            {
+                this->m_status = Lept::PARSE_INVALID_UNICODE_SURROGATE;
+                return p;
+            }
+            if (this->m_sub == STRING_LOW_U)
+            {
+                this->m_hex = 0;
+                this->m_count = 0;
+            }
+            this->m_sub = (this->m_sub == STRING_LOW_BACKSLASH) ? STRING_LOW_U : STRING_LOW_HEX;
+            break;
+        }
+        ++p;
+    }
+
+    return p;
+}
+int Lept::Reader::endString(void)
+{
+    bool ok;
+
+    if (this->m_isKey)
+    {
+        ok = this->m_handler->onKey(this->m_buffer);
+        this->m_token = TOKEN_NONE;
+        this->m_state = READER_COLON;
+    }
+    else
+    {
+        ok = this->m_handler->onString(this->m_buffer);
+        this->endValue();
+    }
+
+    return ok ? Lept::PARSE_OK : Lept::PARSE_HANDLER_ABORTED;
+}
+#endif
+
+int Lept::Reader::feed(const char* data, size_t len)
+{
+    const char* p = data;
+    const char* end = data + len;
+
+    while (p < end && this->m_status == Lept::PARSE_OK)
+    {
+        /* finish the token left open by the previous chunk, or the one just started */
+        switch (this->m_token)
+        {
+        case TOKEN_LITERAL:
+            p = this->readLiteral(p, end);
+            continue;
+        case TOKEN_NUMBER:
+            p = this->readNumber(p, end);
+            continue;
+        case TOKEN_STRING:
+            p = this->readString(p, end);
+            continue;
+        }
+
+        char ch = *p;
+        if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')
+        {
+            ++p;
+            continue;
+        }
+
+        int ret = Lept::PARSE_OK;
+        char top = this->m_stack.empty() ? '\0' : this->m_stack.back();
+        switch (this->m_state)
+        {
+        case READER_VALUE_OR_CLOSE:
+            if (ch == ']')
+            {
+                ret = this->closeContainer(ch);
+                break;
+            }
+            /* fall through */
+        case READER_VALUE:
+            ret = this->startValue(ch);
+            break;
+        case READER_KEY_OR_CLOSE:
+            if (ch == '}')
+            {
+                ret = this->closeContainer(ch);
+                break;
+            }
+            /* fall through */
+        case READER_KEY:
+            if (ch != '\"')
+            {
+                ret = Lept::PARSE_MISSING_KEY;
+                break;
+            }
+            this->m_token = TOKEN_STRING;
+            this->m_sub = STRING_CHAR;
+            this->m_isKey = true;
+            this->m_buffer.clear();
+            break;
+        case READER_COLON:
+            if (ch != ':')
+                ret = Lept::PARSE_MISSING_COLON;
+            else
+                this->m_state = READER_VALUE;
+            break;
+        case READER_COMMA_OR_CLOSE:
+            if (ch == ',')
+                this->m_state = (top == '[') ? READER_VALUE : READER_KEY;
+            else if (ch == ((top == '[') ? ']' : '}'))
+                ret = this->closeContainer(ch);
+            else
+                ret = (top == '[') ? Lept::PARSE_MISSING_COMMA_OR_BRACKET : Lept::PARSE_MISSING_COMMA_OR_BRACE;
+            break;
+        case READER_END:
+            ret = Lept::PARSE_ROOT_NOT_SINGULAR;
+            break;
+        }
+
+        if (ret != Lept::PARSE_OK && ret != Lept::PARSE_HANDLER_ABORTED)
+        { /* p stays on the offending char */
+            this->m_status = ret;
+            break;
+        }
+        this->m_status = ret;
+        ++p;
+    }
+    this->m_offset += p - data;
+
+    return this->m_status;
+}
+int Lept::Reader::finish(void)
+{
+    if (this->m_status != Lept::PARSE_OK)
+        return this->m_status;
+
+    switch (this->m_token)
+    {
+    case TOKEN_LITERAL:
+        this->m_status = Lept::PARSE_INVALID_VALUE;
+        return this->m_status;
+    case TOKEN_NUMBER:
+        if ((this->m_status = this->endNumber()) != Lept::PARSE_OK)
+            return this->m_status;
+        break;
+    case TOKEN_STRING:
+        if (this->m_sub == STRING_CHAR)
+            this->m_status = Lept::PARSE_MISSING_QUOTATION_MARK;
+        else if (this->m_sub == STRING_ESCAPE)
+            this->m_status = Lept::PARSE_INVALID_STRING_ESCAPE;
+        else if (this->m_sub == STRING_HEX)
+            this->m_status = Lept::PARSE_INVALID_UNICODE_HEX;
+        else
+            this->m_status = Lept::PARSE_INVALID_UNICODE_SURROGATE;
+        return this->m_status;
+    }
+
+    switch (this->m_state)
+    {
+    case READER_VALUE:
+    case READER_VALUE_OR_CLOSE:
+        this->m_status = Lept::PARSE_EXPECT_VALUE;
+        break;
+    case READER_KEY:
+    case READER_KEY_OR_CLOSE:
+        this->m_status = Lept::PARSE_MISSING_KEY;
+        break;
+    case READER_COLON:
+        this->m_status = Lept::PARSE_MISSING_COLON;
+        break;
+    case READER_COMMA_OR_CLOSE:
+        this->m_status = (this->m_stack.back() == '[') ? Lept::PARSE_MISSING_COMMA_OR_BRACKET : Lept::PARSE_MISSING_COMMA_OR_BRACE;
+        break;
+    }
+
+    return this->m_status;
+}
+#endif
+
+
+/* -------- Lept::Reformatter -------- */
+#if 1
+// Constructor; 
+Lept::Reformatter::Reformatter(Lept::Writer& w) :
+    m_writer(&w),
+    m_first(true),
+    m_afterKey(false)
+{
+
+}
+// Destructor; 
+Lept::Reformatter::~Reformatter(void)
+{
+
+}
+
+/* separate a value from the previous element the way Value::stringify() does */
+bool Lept::Reformatter::beginValue(void)
+{
+    if (this->m_afterKey)
+        this->m_afterKey = false;
+    else if (this->m_writer->getLevel() != 0)
+    {
+        if (!this->m_first)
+            this->m_writer->put(',');
+        this->m_writer->breakLine();
+    }
+    this->m_first = false;
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+
+bool Lept::Reformatter::onNull(void)
+{
+    this->beginValue();
+    this->m_writer->write("null", 4);
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onBoolean(bool bln)
+{
+    this->beginValue();
+    if (bln)
+        this->m_writer->write("true", 4);
+    else
+        this->m_writer->write("false", 5);
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onNumber(double num, const char* txt, size_t len)
+{
+    (void)num;
+    this->beginValue();
+    this->m_writer->write(txt, len);
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onString(const std::string& str)
+{
+    this->beginValue();
+    this->m_writer->writeString(str);
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onStartArray(void)
+{
+    this->beginValue();
+    this->m_writer->put('[');
+    this->m_writer->levelUp();
+    this->m_first = true;
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onEndArray(void)
+{
+    this->m_writer->levelDown();
+    this->m_writer->breakLine();
+    this->m_writer->put(']');
+    this->m_first = false;
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onStartObject(void)
+{
+    this->beginValue();
+    this->m_writer->put('{');
+    this->m_writer->levelUp();
+    this->m_first = true;
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onKey(const std::string& key)
+{
+    this->beginValue();
+    this->m_writer->writeString(key);
+    this->m_writer->put(':');
+    this->m_afterKey = true;
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+bool Lept::Reformatter::onEndObject(void)
+{
+    this->m_writer->levelDown();
+    this->m_writer->breakLine();
+    this->m_writer->put('}');
+    this->m_first = false;
+
+    return (this->m_writer->getStatus() == Lept::STRINGIFY_OK);
+}
+#endif
+
+
+/* -------- Lept::Builder -------- */
+#if 1
+// Constructor; 
+Lept::Builder::Builder(Lept::Value& root) :
+    m_root(&root)
+{
+    this->reset();
+}
+// Destructor; 
+Lept::Builder::~Builder(void)
+{
+
+}
+
+void Lept::Builder::reset(void)
+{
+    this->m_root->setType(Lept::Type::NULLJSON);
+    this->m_stack.clear();
+    this->m_key.clear();
+
+    return;
+}
+Lept::Value& Lept::Builder::place(void)
+{
+    if (this->m_stack.empty())
+        return *this->m_root;
+
+    Lept::Value* top = this->m_stack.back();
+    Lept::Value* v = new Lept::Value;
+    if (top->getType() == Lept::Type::ARRAY)
+        top->appendArrElem(*v);
+    else
+    {
+        Lept::Member* m = new Lept::Member;
+        m->key = new std::string;
+        m->key->swap(this->m_key);
+        m->value = v;
+        top->appendObjElem(*m);
+    }
+
+    return *v;
+}
+
+bool Lept::Builder::onNull(void)
+{
+    this->place().setNull();
+
+    return true;
+}
+bool Lept::Builder::onBoolean(bool bln)
+{
+    this->place().setBoolean(bln);
+
+    return true;
+}
+bool Lept::Builder::onNumber(double num, const char* txt, size_t len)
+{
+    (void)txt;
+    (void)len;
+    this->place().setNum(num);
+
+    return true;
+}
+bool Lept::Builder::onString(const std::string& str)
+{
+    Lept::Value& v = this->place();
+    v.setType(Lept::Type::STRING);
+    v.setStr(str);
+
+    return true;
+}
+bool Lept::Builder::onStartArray(void)
+{
+    Lept::Value& v = this->place();
+    v.setType(Lept::Type::ARRAY);
+    this->m_stack.push_back(&v);
+
+    return true;
+}
+bool Lept::Builder::onEndArray(void)
+{
+    this->m_stack.pop_back();
+
+    return true;
+}
+bool Lept::Builder::onStartObject(void)
+{
+    Lept::Value& v = this->place();
+    v.setType(Lept::Type::OBJECT);
+    this->m_stack.push_back(&v);
+
+    return true;
+}
+bool Lept::Builder::onKey(const std::string& key)
+{
+    this->m_key = key;
+
+    return true;
+}
+bool Lept::Builder::onEndObject(void)
+{
+    this->m_stack.pop_back();
+
+    return true;
+}
+#endif
+
+
+/* -------- Lept::PushParser -------- */
+#if 1
+// Constructor; 
+Lept::PushParser::PushParser(Lept::Value& v) :
+    m_builder(v),
+    m_reader(m_builder)
+{
+
+}
+// Destructor; 
+Lept::PushParser::~PushParser(void)
+{
+
+}
+
+/* get-Functions */
+int Lept::PushParser::getStatus(void) const
+{
+    return this->m_reader.getStatus();
+}
+size_t Lept::PushParser::getOffset(void) const
+{
+    return this->m_reader.getOffset();
+}
+
+/* set-Functions */
+void Lept::PushParser::reset(void)
+{
+    this->m_builder.reset();
+    this->m_reader.reset();
+
+    return;
+}
+
+int Lept::PushParser::feed(const char* data, size_t len)
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::PARSE);
+    int ret = this->m_reader.feed(data, len);
+    if (ret != Lept::PARSE_OK)
+        this->m_builder.reset(); /* drop the partial tree */
+
+    return ret;
+}
+int Lept::PushParser::finish(void)
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::PARSE);
+    int ret = this->m_reader.finish();
+    if (ret != Lept::PARSE_OK)
+        this->m_builder.reset();
+
+    return ret;
+}
+#endif
+
+
+/* -------- Lept::Minifier -------- */
+#if 1
+/* one bit per byte of a 64-byte block */
+typedef struct
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t space; /* insignificant whitespace if outside a string */
+} MinifyMasks;
+
+static void minifyClassify(const char* p, MinifyMasks* m)
+{
+    m->quote = m->backslash = m->space = 0;
+#ifdef LEPT_MINIFY_SSE2
+    const __m128i quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(' '), tab = _mm_set1_epi8('\t'), lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r');
+    for (int index = 0; index < 64; index += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + index));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)), _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        m->quote |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << index;
+        m->backslash |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << index;
+        m->space |= (uint64_t)(unsigned int)_mm_movemask_epi8(ws) << index;
+    }
+#else
+    for (int index = 0; index < 64; ++index)
+    {
+        char ch = p[index];
+        uint64_t bit = (uint64_t)1 << index;
+        if (ch == '"')
+            m->quote |= bit;
+        else if (ch == '\\')
+            m->backslash |= bit;
+        else if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')
+            m->space |= bit;
+    }
+#endif
+
+    return;
+}
+/* bits of the bytes escaped by a backslash, 
+ * *carry holds 1 if the block before ended with an odd run of backslashes */
+static uint64_t minifyEscaped(uint64_t backslash, uint64_t* carry)
+{
+    const uint64_t oddBits = 0xAAAAAAAAAAAAAAAAULL;
+    if (backslash == 0)
+    {
+        uint64_t escaped = *carry;
+        *carry = 0;
+        return escaped;
+    }
+    /* subtracting the backslashes from the odd bits carries through each run, 
+     * leaving the byte after it flipped when the run has odd length */
+    uint64_t escaping = backslash & ~*carry; /* an escaped backslash escapes nothing */
+    uint64_t evenRuns = ((escaping << 1) | oddBits) - escaping;
+    uint64_t escapeOrEnd = evenRuns ^ oddBits;
+    uint64_t escaped = escapeOrEnd ^ (backslash | *carry);
+    *carry = (escapeOrEnd & backslash) >> 63;
+
+    return escaped;
+}
+/* bit i set if an odd number of bits up to i are, 
+ * the quote that opens a string is inside it and the one closing it is not */
+static uint64_t minifyPrefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+static int minifyTrailingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    int count = 0;
+    for (; !(bits & 1); bits >>= 1)
+        ++count;
+    return count;
+#endif
+}
+/* copy the bytes of p whose keep bit is set to q, run by run, return the end of output */
+static char* minifyCompressRuns(const char* p, uint64_t keep, char* q)
+{
+    while (keep != 0)
+    {
+        int begin = minifyTrailingZeros(keep);
+        uint64_t rest = ~(keep >> begin);
+        int len = (rest != 0) ? minifyTrailingZeros(rest) : 64 - begin;
+        memcpy(q, p + begin, (size_t)len);
+        q += len;
+        keep = (begin + len < 64) ? keep & (~(uint64_t)0 << (begin + len)) : 0;
+    }
 
-            switch (*this->getTxt())
+    return q;
+}
+#ifdef LEPT_MINIFY_SSSE3
+/* pshufb control moving the bytes set in each 8-bit mask to the front, 
+ * 0x80 zeroes the bytes left over */
+static const uint64_t* minifyShuffleTable(void)
+{
+    static uint64_t table[256];
+    static bool built = []() {
+        for (unsigned int mask = 0; mask < 256; ++mask)
+        {
+            uint64_t entry = 0;
+            int count = 0;
+            for (int index = 0; index < 8; ++index)
             {
-            case '\"':
-            case '/':
-            case '\\':
-                str->push_back(*this->getTxt());
-                this->txtIncre();
-                break;
-            case 'b':
-                str->push_back('\b');
-                this->txtIncre();
-                break;
-            case 'f':
-                str->push_back('\f');
-                this->txtIncre();
-                break;
-            case 'n':
-                str->push_back('\n');
-                this->txtIncre();
-                break;
-            case 'r':
-                str->push_back('\r');
-                this->txtIncre();
-                break;
-            case 't':
-                str->push_back('\t');
-                this->txtIncre();
-                break;
-            case 'u': /* Unicode UTF-8 */
-                ret = Lept::PARSE_OK;
-                this->parseHex(str, ret);
-                if (ret != Lept::PARSE_OK)
-                    return ret;
-                break;
-            default:
-                return Lept::PARSE_INVALID_STRING_ESCAPE;
+                if (mask & (1u << index))
+                    entry |= (uint64_t)index << (8 * count++);
             }
+            for (; count < 8; ++count)
+                entry |= (uint64_t)0x80 << (8 * count);
+            table[mask] = entry;
         }
-        else if (*this->getTxt() >= '\x20') /* need NOT check " and \ here, 'cuz they've been blocked by if and while */
-        { /* now for unescaped characters */
-            str->push_back(*this->getTxt());
-            this->txtIncre();
-        }
-        else
-            return Lept::PARSE_INVALID_STRING_CHAR;
+        return true;
+    }();
+    (void)built;
+
+    return table;
+}
+/* same as minifyCompressRuns() 16 bytes at a time, stores up to 8 bytes past the end of output */
+__attribute__((target("ssse3")))
+static char* minifyCompressShuffle(const char* p, uint64_t keep, char* q)
+{
+    const uint64_t* table = minifyShuffleTable();
+    for (int index = 0; index < 64; index += 16)
+    {
+        unsigned int low = (unsigned int)(keep >> index) & 0xFF, high = (unsigned int)(keep >> (index + 8)) & 0xFF;
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + index));
+        /* the high half picks from bytes 8 to 15 */
+        __m128i control = _mm_set_epi64x((long long)(table[high] + 0x0808080808080808ULL), (long long)table[low]);
+        __m128i packed = _mm_shuffle_epi8(v, control);
+        _mm_storel_epi64((__m128i*)q, packed);
+        q += __builtin_popcount(low);
+        _mm_storel_epi64((__m128i*)q, _mm_unpackhi_epi64(packed, packed));
+        q += __builtin_popcount(high);
     }
-    this->txtIncre();
 
-    return Lept::PARSE_OK;
+    return q;
 }
-int Lept::Context::parseString(Lept::Value& v)
+#endif
+
+// Constructor; 
+Lept::Minifier::Minifier(Lept::Writer& w, bool validate) :
+    m_writer(&w),
+    m_validate(validate),
+    m_reader(*this),
+    m_inString(false),
+    m_escaped(false),
+    m_offset(0),
+    m_out(LEPT_MINIFY_BUFFER_SIZE + 64)
 {
-    std::string* str = new std::string;
-    int ret = Lept::PARSE_OK;
 
-    if ((ret = this->parseString(str)) != Lept::PARSE_OK)
-        return ret;
+}
+// Destructor; 
+Lept::Minifier::~Minifier(void)
+{
 
-    v.setType(Lept::Type::STRING);
-    v.setStr(str); 
+}
 
-    return ret;
+/* get-Functions */
+size_t Lept::Minifier::getOffset(void) const
+{
+    return this->m_offset;
 }
-int Lept::Context::parseArray(Lept::Value& v)
+
+/* set-Functions */
+void Lept::Minifier::reset(void)
 {
-    EXPECT(this, '[');
+    this->m_reader.reset();
+    this->m_inString = false;
+    this->m_escaped = false;
+    this->m_offset = 0;
 
-    Lept::Value* cache; 
-    int ret = Lept::PARSE_OK; 
-    v.setType(Lept::Type::ARRAY); 
-    this->parseWs(); 
+    return;
+}
 
-    while (*this->getTxt() != ']')
+int Lept::Minifier::feed(const char* data, size_t len)
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY);
+    if (this->m_validate)
     {
-        cache = new Lept::Value; 
-        ret = this->parseValue(*cache);
+        int ret = this->m_reader.feed(data, len);
         if (ret != Lept::PARSE_OK)
         {
-            v.setType(Lept::Type::NULLJSON);
+            this->m_offset = this->m_reader.getOffset();
             return ret;
         }
-        v.appendArrElem(*cache);
+    }
 
-        this->parseWs(); 
-        if (*this->getTxt() == ']')
-            continue; 
-        else if (*this->getTxt() == ',')
+#ifdef LEPT_MINIFY_SSSE3
+    static const bool shuffle = __builtin_cpu_supports("ssse3");
+#endif
+    char* out = this->m_out.data();
+    char* q = out;
+    const char* p = data;
+    const char* end = data + len;
+    /* whole 64-byte blocks: string state as masks, all ones inside a string */
+    uint64_t inString = this->m_inString ? ~(uint64_t)0 : 0;
+    uint64_t escapedCarry = this->m_escaped ? 1 : 0;
+    for (; end - p >= 64; p += 64)
+    {
+        MinifyMasks m;
+        minifyClassify(p, &m);
+        uint64_t quote = m.quote & ~minifyEscaped(m.backslash, &escapedCarry);
+        uint64_t string = minifyPrefixXor(quote) ^ inString;
+        inString = (uint64_t)((int64_t)string >> 63);
+        uint64_t keep = ~(m.space & ~string);
+
+        if (keep == ~(uint64_t)0)
         {
-            this->txtIncre();
-            this->parseWs();
+            memcpy(q, p, 64);
+            q += 64;
         }
+#ifdef LEPT_MINIFY_SSSE3
+        else if (shuffle)
+            q = minifyCompressShuffle(p, keep, q);
+#endif
         else
+            q = minifyCompressRuns(p, keep, q);
+        if (q - out >= LEPT_MINIFY_BUFFER_SIZE)
         {
-            v.setType(Lept::Type::NULLJSON);
-            return Lept::PARSE_MISSING_COMMA_OR_BRACKET;
+            this->m_writer->write(out, (size_t)(q - out));
+            q = out;
         }
     }
-    this->txtIncre(); 
+    /* the rest byte by byte */
+    bool isString = (inString != 0), escaped = (escapedCarry != 0);
+    for (; p < end; ++p)
+    {
+        char ch = *p;
+        if (escaped)
+            escaped = false;
+        else if (ch == '\\')
+            escaped = true;
+        else if (ch == '"')
+            isString = !isString;
+        else if (!isString && (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'))
+            continue;
+        *q++ = ch;
+    }
+    this->m_inString = isString;
+    this->m_escaped = escaped;
+    this->m_writer->write(out, (size_t)(q - out));
+    this->m_offset += len;
 
-    return ret; 
+    return Lept::PARSE_OK;
 }
-/* parse objects */
-int Lept::Context::parseObject(Lept::Value& v)
+int Lept::Minifier::finish(void)
 {
-    EXPECT(this, '{');
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY);
+    if (this->m_validate)
+        return this->m_reader.finish();
 
-    Lept::Member* cache;
-    std::string* key; 
-    Lept::Value* value; 
-    int ret = Lept::PARSE_OK;
-    v.setType(Lept::Type::OBJECT);
-    this->parseWs();
+    return this->m_inString ? Lept::PARSE_MISSING_QUOTATION_MARK : Lept::PARSE_OK;
+}
 
-    while (*this->getTxt() != '}')
+/* validation only needs the Reader to accept every event */
+bool Lept::Minifier::onNull(void)
+{
+    return true;
+}
+bool Lept::Minifier::onBoolean(bool bln)
+{
+    return true;
+}
+bool Lept::Minifier::onNumber(double num, const char* txt, size_t len)
+{
+    return true;
+}
+bool Lept::Minifier::onString(const std::string& str)
+{
+    return true;
+}
+bool Lept::Minifier::onStartArray(void)
+{
+    return true;
+}
+bool Lept::Minifier::onEndArray(void)
+{
+    return true;
+}
+bool Lept::Minifier::onStartObject(void)
+{
+    return true;
+}
+bool Lept::Minifier::onKey(const std::string& key)
+{
+    return true;
+}
+bool Lept::Minifier::onEndObject(void)
+{
+    return true;
+}
+#endif
+
+
+/* -------- canonical form (RFC 8785) -------- */
+#if 1
+/* UTF-8 bytes reordered so that byte order is UTF-16 code unit order: 
+ * U+E000 to U+FFFF (lead bytes EE, EF) move after the supplementary planes (F0 to F4), 
+ * whose surrogates sort below them in UTF-16; other bytes keep code point order */
+static unsigned int canonicalByte(unsigned char ch)
+{
+    if (ch >= 0xF0 && ch <= 0xF4)
+        return ch - 2; 
+    if (ch == 0xEE || ch == 0xEF)
+        return ch + 5; 
+
+    return ch; 
+}
+/* negative, zero or positive as key a sorts before, with or after key b, both equal up to depth */
+static int canonicalCompare(const std::string& a, const std::string& b, size_t depth)
+{
+    size_t len = std::min(a.size(), b.size()); 
+    for (size_t index = depth; index < len; ++index)
     {
-        cache = new Lept::Member;
-        key = new std::string;
-        if (*this->getTxt() != '\"')
-        {
-            v.setType(Lept::Type::NULLJSON);
-            return Lept::PARSE_MISSING_KEY;
-        }
-        ret = this->parseString(key);
-        if (ret != Lept::PARSE_OK)
-        {
-            v.setType(Lept::Type::NULLJSON);
-            return ret;
-        }
-        cache->key = key; 
+        if (a[index] != b[index])
+            return (int)canonicalByte((unsigned char)a[index]) - (int)canonicalByte((unsigned char)b[index]); 
+    }
 
-        this->parseWs(); 
-        if (*this->getTxt() != ':')
-        {
-            v.setType(Lept::Type::NULLJSON);
-            return Lept::PARSE_MISSING_COLON;
-        }
-        this->txtIncre(); 
-        this->parseWs();
+    return (a.size() < b.size()) ? -1 : (a.size() > b.size()) ? 1 : 0; 
+}
+/* MSD radix sort of members by key, byte depth onwards, scratch holds at least len members; 
+ * keys are never copied, narrow buckets fall back to comparison sorting */
+static void canonicalSort(const Lept::Member** members, size_t len, const Lept::Member** scratch, size_t depth)
+{
+    if (len < LEPT_CANONICAL_RADIX_MIN)
+    {
+        std::sort(members, members + len, [depth](const Lept::Member* a, const Lept::Member* b) {
+            return canonicalCompare(*a->key, *b->key, depth) < 0; 
+        }); 
+        return; 
+    }
 
-        value = new Lept::Value;
-        ret = this->parseValue(*value);
-        if (ret != Lept::PARSE_OK)
+    /* bucket 0 holds keys ending at depth, they sort first */
+    size_t begin[258] = { 0 }; 
+    for (size_t index = 0; index < len; ++index)
+    {
+        const std::string& key = *members[index]->key; 
+        ++begin[(depth < key.size()) ? canonicalByte((unsigned char)key[depth]) + 2 : 1]; 
+    }
+    for (size_t bucket = 1; bucket < 258; ++bucket)
+        begin[bucket] += begin[bucket - 1]; 
+    /* begin[bucket] is now where bucket starts, and becomes where it ends while scattering */
+    for (size_t index = 0; index < len; ++index)
+    {
+        const std::string& key = *members[index]->key; 
+        scratch[begin[(depth < key.size()) ? canonicalByte((unsigned char)key[depth]) + 1 : 0]++] = members[index]; 
+    }
+    memcpy(members, scratch, len * sizeof(*members)); 
+
+    for (size_t bucket = 1, start = begin[0]; bucket < 257; start = begin[bucket++])
+    {
+        if (begin[bucket] - start > 1)
+            canonicalSort(members + start, begin[bucket] - start, scratch, depth + 1); 
+    }
+
+    return; 
+}
+/* ECMAScript Number::toString() of the shortest digits that read back as num, 
+ * buffer holds at least 32 chars, return the length */
+static size_t canonicalNumber(double num, char* buffer)
+{
+    char* p = buffer; 
+    if (num == 0)
+    { /* "-0" too */
+        *p = '0'; 
+        return 1; 
+    }
+    if (num < 0)
+    {
+        *p++ = '-'; 
+        num = -num; 
+    }
+    if (num < 9007199254740992.0 && num == (double)(long long)num)
+        return (size_t)(p - buffer) + (size_t)snprintf(p, 31, "%lld", (long long)num); 
+
+    /* decimals of up to 15 digits survive a trip through a normal double, so when 15 digits 
+     * read back they are the shortest form padded with zeros, stripped below; otherwise 16 or 17 do; 
+     * subnormals carry fewer bits, the precision that reads back is searched in [1, 17] */
+    char sci[32]; 
+    int low = (num >= DBL_MIN) ? 15 : 1, high = 17, formatted = 0; 
+    while (low < high)
+    {
+        int mid = (num >= DBL_MIN) ? low : (low + high) / 2; 
+        snprintf(sci, sizeof(sci), "%.*e", mid - 1, num); 
+        formatted = mid; 
+        if (strtod(sci, nullptr) == num)
+            high = mid; 
+        else
+            low = mid + 1; 
+    }
+    if (formatted != low)
+        snprintf(sci, sizeof(sci), "%.*e", low - 1, num); 
+
+    /* "d.ddde+XX" into digits and n, the decimal exponent with the point before the digits */
+    char digits[20]; 
+    int k = 0; 
+    const char* q = sci; 
+    for (; *q != 'e'; ++q)
+    {
+        if (*q != '.')
+            digits[k++] = *q; 
+    }
+    int n = atoi(q + 1) + 1; 
+    while (k > 1 && digits[k - 1] == '0')
+        --k; 
+
+    if (k <= n && n <= 21)
+    {
+        memcpy(p, digits, k); 
+        memset(p + k, '0', n - k); 
+        p += n; 
+    }
+    else if (0 < n && n <= 21)
+    {
+        memcpy(p, digits, n); 
+        p[n] = '.'; 
+        memcpy(p + n + 1, digits + n, k - n); 
+        p += k + 1; 
+    }
+    else if (-6 < n && n <= 0)
+    {
+        *p++ = '0'; 
+        *p++ = '.'; 
+        memset(p, '0', -n); 
+        p += -n; 
+        memcpy(p, digits, k); 
+        p += k; 
+    }
+    else
+    {
+        *p++ = digits[0]; 
+        if (k > 1)
         {
-            v.setType(Lept::Type::NULLJSON);
-            return ret;
+            *p++ = '.'; 
+            memcpy(p, digits + 1, k - 1); 
+            p += k - 1; 
         }
-        cache->value = value; 
+        p += snprintf(p, 8, "e%c%d", (n - 1 < 0) ? '-' : '+', std::abs(n - 1)); 
+    }
 
-        v.appendObjElem(*cache);
+    return (size_t)(p - buffer); 
+}
+/* quoted with the escapes RFC 8785 keeps: \" \\ \b \f \n \r \t and lowercase \u00xx */
+static void canonicalString(Lept::Writer& w, const std::string& str)
+{
+    static const char hexDigits[] = "0123456789abcdef"; 
+    const char* p = str.data(); 
+    size_t len = str.size(), head = 0; 
 
-        this->parseWs();
-        if (*this->getTxt() == '}')
-            continue;
-        else if (*this->getTxt() == ',')
+    w.put('\"'); 
+    for (size_t index = 0; index < len; ++index)
+    {
+        unsigned char cur = (unsigned char)p[index]; 
+        if (cur >= 0x20 && cur != '\"' && cur != '\\')
+            continue; 
+
+        w.write(p + head, index - head); 
+        head = index + 1; 
+        char esc = escapeOf(cur); 
+        if (esc == 'u')
         {
-            this->txtIncre();
-            this->parseWs();
+            char buffer[6] = { '\\', 'u', '0', '0', hexDigits[cur >> 4], hexDigits[cur & 0xF] }; 
+            w.write(buffer, 6); 
         }
         else
         {
-            v.setType(Lept::Type::NULLJSON);
-            return Lept::PARSE_MISSING_COMMA_OR_BRACE;
+            char buffer[2] = { '\\', esc }; 
+            w.write(buffer, 2); 
         }
     }
-    this->txtIncre();
+    w.write(p + head, len - head); 
+    w.put('\"'); 
 
-    return ret;
+    return; 
 }
-/* parse JSON values */
-int Lept::Context::parseValue(Lept::Value& v)
+/* order holds the sorted members of every open object, scratch serves the radix sort, 
+ * both are reused from one object to the next */
+static int stringifyCanonical(const Lept::Value& v, Lept::Writer& w, std::vector<const Lept::Member*>& order, std::vector<const Lept::Member*>& scratch)
 {
-    char txt = *this->getTxt();
+    char buffer[32]; 
+    size_t len = 0, base = 0; 
 
-    switch (txt)
+    switch (v.getType())
     {
-    case 'n': // NULL; 
-        return this->parseLiteral(v, "null", Lept::Type::NULLJSON);
-    case 'f': // FALSE; 
-        return this->parseLiteral(v, "false", Lept::Type::FALSE);
-    case 't': // TRUE; 
-        return this->parseLiteral(v, "true", Lept::Type::TRUE);
-    default: // numbers or invalid JSON context; 
-        return this->parseNumber(v);
-    case '\"': // strings; 
-        return this->parseString(v);
-    case '[': // arrays; 
-        return this->parseArray(v);
-    case '{': // objects; 
-        return this->parseObject(v); 
-    case '\0': // reach the end of JSON context and have read nothing;
-        return Lept::PARSE_EXPECT_VALUE;
+    case Lept::Type::NULLJSON:
+    case Lept::Type::FALSE:
+    case Lept::Type::TRUE:
+        v.stringifyLiteral(w); 
+        break; 
+    case Lept::Type::NUMBER:
+        if (!std::isfinite(v.getNum()))
+            return Lept::STRINGIFY_NOT_FINITE; 
+        w.write(buffer, canonicalNumber(v.getNum(), buffer)); 
+        break; 
+    case Lept::Type::STRING:
+        canonicalString(w, *v.getStr()); 
+        break; 
+    case Lept::Type::ARRAY:
+        len = v.getArr()->size(); 
+        w.put('['); 
+        for (size_t index = 0; index < len; ++index)
+        {
+            if (index != 0)
+                w.put(','); 
+            int ret = stringifyCanonical(*v.getArr()->at(index), w, order, scratch); 
+            if (ret != Lept::STRINGIFY_OK)
+                return ret; 
+        }
+        w.put(']'); 
+        break; 
+    case Lept::Type::OBJECT:
+        len = v.getObj()->size(); 
+        base = order.size(); 
+        order.insert(order.end(), v.getObj()->begin(), v.getObj()->end()); 
+        if (scratch.size() < len)
+            scratch.resize(len); 
+        canonicalSort(order.data() + base, len, scratch.data(), 0); 
+
+        w.put('{'); 
+        for (size_t index = 0; index < len; ++index)
+        { /* nested objects append to order, go by index */
+            if (index != 0)
+                w.put(','); 
+            canonicalString(w, *order[base + index]->key); 
+            w.put(':'); 
+            int ret = stringifyCanonical(*order[base + index]->value, w, order, scratch); 
+            if (ret != Lept::STRINGIFY_OK)
+                return ret; 
+        }
+        w.put('}'); 
+        order.resize(base); 
+        break; 
     }
+
+    return Lept::STRINGIFY_OK; 
+}
+
+int Lept::Value::stringifyCanonical(Lept::Writer& w) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+    std::vector<const Lept::Member*> order, scratch; 
+    int ret = ::stringifyCanonical(*this, w, order, scratch); 
+
+    return (ret != Lept::STRINGIFY_OK) ? ret : w.getStatus(); 
+}
+int Lept::Value::stringifyCanonical(std::string& JSONCache) const
+{
+    LEPT_ALLOC_SCOPE(Lept::AllocPhase::STRINGIFY); 
+    static const Lept::Format compactFormat('\t', 1, Lept::Newline::NONE); 
+
+    JSONCache.clear(); 
+    Lept::StringWriter w(JSONCache, compactFormat); 
+    int ret = this->stringifyCanonical(w); 
+    if (ret == Lept::STRINGIFY_OK)
+        ret = w.flush(); 
+    if (ret != Lept::STRINGIFY_OK)
+        JSONCache.clear(); 
+
+    return ret; 
 }
 #endif
-#endif
\ No newline at end of file
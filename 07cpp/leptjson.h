@@ -4,6 +4,29 @@
 #include <string> /* std::string */
 #include <vector> /* std::vector */
 #include <fstream> /* std::ofstream */
+#include <ostream> /* std::ostream */
+#include <cstdio> /* FILE */
+
+/* indentation levels emitted by a single append, deeper levels take one more append per cached block */
+#ifndef LEPT_INDENT_CACHE_LEVEL
+#define LEPT_INDENT_CACHE_LEVEL 64
+#endif
+/* bytes a writer buffers before handing them to its sink */
+#ifndef LEPT_WRITER_BUFFER_SIZE
+#define LEPT_WRITER_BUFFER_SIZE 4096
+#endif
+/* containers shorter than this are never split across threads */
+#ifndef LEPT_PARALLEL_MIN_ELEMENTS
+#define LEPT_PARALLEL_MIN_ELEMENTS 4096
+#endif
+/* deepest nesting a Lept::Cursor can resume from */
+#ifndef LEPT_CURSOR_MAX_DEPTH
+#define LEPT_CURSOR_MAX_DEPTH 128
+#endif
+/* objects of at least this many members are sorted by radix for the canonical form */
+#ifndef LEPT_CANONICAL_RADIX_MIN
+#define LEPT_CANONICAL_RADIX_MIN 32
+#endif
 
 namespace Lept
 {
@@ -27,6 +50,242 @@ namespace Lept
         Lept::Value* value;
     } Member; 
 
+    /* JSON stringifier line break style */
+    enum class Newline
+    {
+        NONE,   /* compact output, neither line breaks nor indentation */
+        LF,     /* "\n" */
+        CRLF    /* "\r\n" */
+    };
+
+    /* JSON stringifier format options */
+    class Writer; 
+    class Format
+    {
+    private:
+        char m_indentChar;
+        unsigned int m_indentWidth;
+        Lept::Newline m_newline;
+        unsigned int m_maxWidth; /* 0 for no limit */
+        /* line break followed by the indentation of the deepest cached level,
+         * any level up to LEPT_INDENT_CACHE_LEVEL is a prefix of it */
+        std::string m_indentBuffer;
+
+        void buildIndentBuffer(void);
+
+    public:
+        // Constructor; 
+        /* with maxWidth, containers whose compact form fits on the rest of their line stay inline, 
+         * columns are counted in bytes, a tab as one */
+        Format(char indentChar = '\t', unsigned int indentWidth = 1, Lept::Newline newline = Lept::Newline::LF, unsigned int maxWidth = 0);
+        // Destructor; 
+        ~Format(void);
+
+        // get-Functions; 
+        char getIndentChar(void) const;
+        unsigned int getIndentWidth(void) const;
+        Lept::Newline getNewline(void) const;
+        unsigned int getMaxWidth(void) const;
+        bool isCompact(void) const;
+
+        // set-Functions; 
+        void setIndentChar(char indentChar);
+        void setIndentWidth(unsigned int indentWidth);
+        void setNewline(Lept::Newline newline);
+        void setMaxWidth(unsigned int maxWidth);
+
+        /* append line break and indentation of level */
+        size_t breakLineSize(int level) const;
+        void breakLine(Lept::Writer& w, int level) const;
+    };
+
+    /* JSON stringifier output state, 
+     * carries the nesting level so that stringification never touches the tree, 
+     * output is buffered and handed to the sink whenever the buffer fills */
+    class Writer
+    {
+    private:
+        const Lept::Format* m_fmt;
+        int m_level;
+        int m_status; /* first sink error, STRINGIFY_OK otherwise */
+        bool m_inline; /* inside a container kept on one line, line breaks are dropped */
+        size_t m_drained; /* bytes handed to the sink so far */
+        size_t m_lineStart; /* offset in the output where the current line starts */
+        size_t m_used;
+        char m_buffer[LEPT_WRITER_BUFFER_SIZE];
+
+    protected:
+        /* hand len bytes to the sink, return STRINGIFY_OK or an error */
+        virtual int drain(const char* data, size_t len) = 0;
+        void setStatus(int status);
+
+    public:
+        // Constructor; 
+        Writer(const Lept::Format& fmt);
+        // Destructor; 
+        virtual ~Writer(void);
+
+        // get-Functions; 
+        const Lept::Format& getFormat(void) const;
+        int getLevel(void) const;
+        int getStatus(void) const;
+        size_t getColumn(void) const; /* bytes since the last line break */
+        bool isInline(void) const;
+
+        // set-Functions; 
+        void levelUp(void);
+        void levelDown(void);
+        void setInline(bool isInline);
+
+        /* append to output */
+        void put(char ch);
+        void write(const char* str, size_t len);
+        void writeString(const std::string& str); /* quoted and escaped */
+        void breakLine(void);
+        /* a line break after a whole document, even in compact formats, the next one starts at column 0 */
+        void endLine(void);
+        virtual void reserve(size_t len); /* hint of the bytes about to be written */
+        virtual void writeChunks(const std::vector<const std::string*>& chunks); /* in order */
+        int flush(void);
+    };
+
+    /* writer sinks, each flushes on destruction */
+    class StringWriter : public Writer
+    {
+    private:
+        std::string* m_cache;
+
+    protected:
+        int drain(const char* data, size_t len);
+
+    public:
+        StringWriter(std::string& JSONCache, const Lept::Format& fmt);
+        ~StringWriter(void);
+
+        void reserve(size_t len); /* grow the string once */
+    };
+    class StreamWriter : public Writer
+    {
+    private:
+        std::ostream* m_os;
+
+    protected:
+        int drain(const char* data, size_t len);
+
+    public:
+        StreamWriter(std::ostream& os, const Lept::Format& fmt);
+        ~StreamWriter(void);
+    };
+    class StdioWriter : public Writer
+    {
+    private:
+        FILE* m_fp;
+
+    protected:
+        int drain(const char* data, size_t len);
+
+    public:
+        StdioWriter(FILE* fp, const Lept::Format& fmt);
+        ~StdioWriter(void);
+    };
+    class FdWriter : public Writer
+    {
+    private:
+        int m_fd;
+
+    protected:
+        int drain(const char* data, size_t len);
+
+    public:
+        FdWriter(int fd, const Lept::Format& fmt);
+        ~FdWriter(void);
+
+        int getFd(void) const;
+        void writeChunks(const std::vector<const std::string*>& chunks); /* writev() where available */
+    };
+    class FileWriter : public FdWriter
+    {
+    public:
+        /* truncate or create path, STRINGIFY_FILE_OPEN_FAILURE status on failure */
+        FileWriter(const char* path, const Lept::Format& fmt);
+        ~FileWriter(void);
+
+        void reserve(size_t len); /* preallocate the file blocks where supported */
+    };
+    /* replaces the file at path atomically, and only if the output differs from it: 
+     * output is compared with the file as it comes, a temporary file next to it is 
+     * written from the first difference on and commit() renames it over path */
+    class ReplaceWriter : public Writer
+    {
+    private:
+        std::string m_path;
+        std::string m_tempPath; /* empty until the output differs */
+        int m_original; /* path opened for reading */
+        int m_temp; /* the temporary file, -1 while the output equals the original */
+        size_t m_same; /* output bytes equal to the original so far */
+        std::vector<char> m_chunk; /* original bytes being compared or copied, LEPT_WRITER_BUFFER_SIZE at most */
+        bool m_changed;
+
+        int openTemp(size_t prefix); /* create the temporary file with the first prefix bytes of path */
+
+    protected:
+        int drain(const char* data, size_t len);
+
+    public:
+        /* STRINGIFY_FILE_OPEN_FAILURE status when path cannot be read */
+        ReplaceWriter(const char* path, const Lept::Format& fmt);
+        ~ReplaceWriter(void); /* removes the temporary file unless committed */
+
+        bool isChanged(void) const; /* after commit(), whether path was replaced */
+        /* flush, then leave path untouched if the output equals it, 
+         * otherwise fsync the temporary file and rename it over path */
+        int commit(void);
+    };
+
+    /* resumable position of a stringification into caller-provided buffers, 
+     * holds no heap memory so that filling a buffer never allocates */
+    class Cursor
+    {
+    private:
+        typedef struct
+        {
+            const Lept::Value* value; /* array or object */
+            size_t index; /* element being written */
+        } Frame;
+
+        const Lept::Format* m_fmt;
+        const Lept::Value* m_value; /* value being written */
+        Frame m_stack[LEPT_CURSOR_MAX_DEPTH];
+        int m_depth;
+        int m_step; /* what comes next, see leptjson.cpp */
+        size_t m_offset; /* bytes of the current piece already written */
+        size_t m_strIndex; /* source bytes of the current string already written */
+        size_t m_column; /* bytes since the last line break */
+        int m_inlineDepth; /* depth of the container kept on one line, 0 if none */
+        char* m_out; /* caller buffer of the ongoing fill() */
+        size_t m_space;
+
+        bool emit(const char* piece, size_t len);
+        bool emitBreakLine(int level);
+        bool emitString(const std::string& str);
+
+    public:
+        // Constructor; 
+        Cursor(const Lept::Format& fmt);
+        // Destructor; 
+        ~Cursor(void);
+
+        // get-Functions; 
+        bool isDone(void) const;
+
+        // set-Functions; 
+        void reset(void); /* start over with the next fill() */
+
+        /* write the next bytes of root into buffer, written tells how many, 
+         * STRINGIFY_NEED_MORE_SPACE means buffer is full and the next call continues */
+        int fill(const Lept::Value& root, char* buffer, size_t size, size_t& written);
+    };
+
     /* JSON tree node structure */
     class Context; 
     class Value
@@ -41,7 +300,6 @@ namespace Lept
             std::vector<Lept::Value*>* m_arr; /* array */
             std::vector<Lept::Member*>* m_obj; /* object */
         }; 
-        int m_level; 
 
     public:
         // Constructor; 
@@ -60,7 +318,6 @@ namespace Lept
         std::vector<Lept::Member*>* getObj(void) const; 
         Lept::Member* getObjElem(void) const; /* get last element */
         Lept::Member* getObjElem(unsigned int index) const; 
-        int getLevel(void) const; 
 
         // set-Functions
         void setType(Lept::Type type); 
@@ -68,14 +325,11 @@ namespace Lept
         void setBoolean(bool bln); 
         void setNum(double num);
         void setStrNew(void); 
-        void setStr(std::string* str); 
+        void setStr(std::string* str); /* takes str over and deletes the old string, str is not copied */
         void setStr(std::string str); 
         void appendChar(char ch); 
         void appendArrElem(Lept::Value &elem); 
         void appendObjElem(Lept::Member& elem); 
-        void setLevel(int level); 
-        void levelUp(void); 
-        void levelDown(void); 
 
         /* parse JSON context to tree structure */
         int parse(Lept::Context &c);
@@ -83,12 +337,27 @@ namespace Lept
         int parse(std::string json);
 
         /* stringify JSON value */
-        int stringifyLiteral(std::string& JSONCache) const;
-        int stringifyNumber(std::string& JSONCache) const;
-        int stringifyString(std::string& JSONCache) const;
-        int stringifyArray(std::string& JSONCache);
-        int stringifyObject(std::string& JSONCache);
-        int stringify(std::string& JSONCache);
+        int stringifyLiteral(Lept::Writer& w) const;
+        int stringifyNumber(Lept::Writer& w) const;
+        int stringifyString(Lept::Writer& w) const;
+        int stringifyArray(Lept::Writer& w) const;
+        int stringifyObject(Lept::Writer& w) const;
+        int stringify(Lept::Writer& w) const;
+        /* split a large root container into chunks stringified on up to threads threads */
+        int stringifyParallel(Lept::Writer& w, unsigned int threads) const;
+        int stringify(std::string& JSONCache, const Lept::Format& fmt, bool presize = false) const;
+        int stringify(std::string& JSONCache) const;
+        int stringifyFile(const char* path, const Lept::Format& fmt, bool presize = false) const;
+        /* allocation-free, resumable, see Lept::Cursor */
+        int stringify(char* buffer, size_t size, size_t& written, Lept::Cursor& cursor) const;
+        /* exact length of the output, escapes and indentation included, for a single reservation */
+        size_t stringifySize(const Lept::Format& fmt) const;
+        /* RFC 8785 canonical form for hashing and signing: no whitespace whatever the Format, 
+         * members ordered by the UTF-16 code units of their keys, shortest round-trip numbers 
+         * as ECMAScript prints them, only the escapes JSON requires; the tree is left as is, 
+         * STRINGIFY_NOT_FINITE stops at a number set to infinity or NaN */
+        int stringifyCanonical(Lept::Writer& w) const;
+        int stringifyCanonical(std::string& JSONCache) const;
     };
 
     /* JSON parser error info */
@@ -107,20 +376,72 @@ namespace Lept
         PARSE_MISSING_COMMA_OR_BRACKET, /* comma or ending bracket missing */
         PARSE_MISSING_KEY, /* key missing */
         PARSE_MISSING_COLON, /* colon missing */
-        PARSE_MISSING_COMMA_OR_BRACE /* comma or ending brace missing */
+        PARSE_MISSING_COMMA_OR_BRACE, /* comma or ending brace missing */
+        PARSE_HANDLER_ABORTED /* a Lept::Handler callback asked to stop */
     };
     /* JSON stringifier error info */
     enum
     {
         STRINGIFY_OK = 0, /* successfully stringified */
-        STRINGIFY_FILE_OPEN_FAILURE /* output target file open error */
+        STRINGIFY_FILE_OPEN_FAILURE, /* output target file open error */
+        STRINGIFY_FILE_WRITE_FAILURE, /* output target rejected a write */
+        STRINGIFY_NEED_MORE_SPACE, /* caller buffer full, call again with the same cursor */
+        STRINGIFY_DEPTH_EXCEEDED, /* nesting deeper than LEPT_CURSOR_MAX_DEPTH */
+        STRINGIFY_NOT_FINITE /* infinity or NaN, which the canonical form has no text for */
+    };
+
+    /* library calls that allocations are attributed to */
+    enum class AllocPhase
+    {
+        OTHER,      /* outside the calls below, Reader and Reformatter on their own included */
+        PARSE,      /* Value::parse(), DocumentStream::next(), PushParser */
+        STRINGIFY,  /* Value::stringify*(), Cursor, Minifier */
+        DESTROY     /* ~Value() and the old contents dropped by Value::setType() */
     };
+    /* allocation counters of one phase */
+    typedef struct
+    {
+        size_t allocs; 
+        size_t frees; 
+        size_t bytes; /* requested by allocs */
+        size_t freedBytes; 
+        size_t peak; /* most bytes live in the process at an allocation of this phase */
+    } AllocStats;
+
+    /* counters since the last resetAllocStats(), summed over all threads, 
+     * only counted when built with LEPT_ALLOC_STATS, which replaces the global operator new and delete; 
+     * all zero otherwise */
+    Lept::AllocStats getAllocStats(Lept::AllocPhase phase);
+    size_t getLiveBytes(void); /* allocated through operator new and not yet freed */
+    /* zero the counters, peaks start again from the bytes live now */
+    void resetAllocStats(void);
+
+    /* what a Lept::Context met in the text, only kept when built with LEPT_CONTEXT_STATS; 
+     * cycles are read with rdtsc on x86 and are steady_clock ticks elsewhere */
+    typedef struct
+    {
+        size_t wsBytes; 
+        size_t stringBytes; /* quotes included, member keys as well */
+        size_t numberBytes; 
+        size_t literalBytes; /* true, false and null */
+        size_t escapes; /* backslash escapes, \uXXXX included */
+        size_t unicodeEscapes; /* \uXXXX, a surrogate pair counts twice */
+        unsigned int maxDepth; /* containers open at once, the root is 1 */
+        unsigned long long wsCycles; 
+        unsigned long long stringCycles; 
+        unsigned long long numberCycles; /* strtod() included */
+    } ContextStats;
 
     /* JSON context */
     class Context
     {
     private:
         const char* m_txt;
+#ifdef LEPT_CONTEXT_STATS
+        Lept::ContextStats m_stats; 
+        unsigned int m_depth; /* containers open at the cursor */
+        class Nesting; /* one level of m_depth while in scope */
+#endif
 
     public:
         // Constructor; 
@@ -130,10 +451,16 @@ namespace Lept
 
         // get-Functions; 
         const char* getTxt(void) const;
+#ifdef LEPT_CONTEXT_STATS
+        const Lept::ContextStats& getStats(void) const; /* summed over every parse since the last resetStats() */
+#endif
 
         // set-Functions; 
         void setTxt(const char* txt);
         void txtIncre(unsigned int inc = 1);
+#ifdef LEPT_CONTEXT_STATS
+        void resetStats(void);
+#endif
 
         /* parse value */
         void parseWs(void);
@@ -147,6 +474,226 @@ namespace Lept
         int parseObject(Lept::Value& v); 
         int parseValue(Lept::Value& v);
     }; 
+
+    /* consecutive JSON values in one NUL-terminated buffer, as in NDJSON / JSON Lines, 
+     * separated by whitespace only and parsed with a single Lept::Context, 
+     * values glued together stop the stream with PARSE_ROOT_NOT_SINGULAR */
+    class DocumentStream
+    {
+    private:
+        const char* m_json;
+        Lept::Context m_context;
+        size_t m_begin; /* byte range of the last document */
+        size_t m_end;
+        int m_status;
+
+    public:
+        // Constructor; 
+        DocumentStream(const char* json);
+        // Destructor; 
+        ~DocumentStream(void);
+
+        // get-Functions; 
+        int getStatus(void) const; /* PARSE_OK unless next() stopped on an error */
+        size_t getBegin(void) const; /* offset of the first byte of the last document */
+        size_t getEnd(void) const; /* offset past the last document, or of the error */
+
+        /* parse the next document into v, false at the end of the buffer or on an error */
+        bool next(Lept::Value& v);
+        /* after an error, go on from the line following the one the failed document began on, 
+         * false if there is none */
+        bool resync(void);
+    };
+
+    /* JSON event receiver of Lept::Reader, 
+     * each callback returns false to stop reading */
+    class Handler
+    {
+    public:
+        virtual ~Handler(void);
+
+        virtual bool onNull(void) = 0;
+        virtual bool onBoolean(bool bln) = 0;
+        virtual bool onNumber(double num, const char* txt, size_t len) = 0; /* txt as written in input */
+        virtual bool onString(const std::string& str) = 0; /* unescaped */
+        virtual bool onStartArray(void) = 0;
+        virtual bool onEndArray(void) = 0;
+        virtual bool onStartObject(void) = 0;
+        virtual bool onKey(const std::string& key) = 0; /* unescaped */
+        virtual bool onEndObject(void) = 0;
+    };
+
+    /* JSON push reader, 
+     * takes input in chunks of any size and suspends inside tokens between them, 
+     * memory grows with nesting depth and the longest string or number only */
+    class Reader
+    {
+    private:
+        Lept::Handler* m_handler;
+        std::vector<char> m_stack; /* '[' or '{' of each open container */
+        int m_state; /* what the grammar expects next, see leptjson.cpp */
+        int m_token; /* token being read across chunks */
+        int m_sub; /* position inside the token */
+        int m_count; /* hex digits read of the current \uxxxx */
+        bool m_isKey;
+        const char* m_literal; /* "null", "true" or "false" */
+        unsigned long m_hex; /* \uxxxx being read */
+        unsigned long m_high; /* pending high surrogate */
+        std::string m_buffer; /* string or number being read */
+        int m_status;
+        size_t m_offset; /* input bytes consumed */
+
+        int startValue(char ch);
+        int endValue(void);
+        int closeContainer(char ch);
+        const char* readLiteral(const char* p, const char* end);
+        const char* readNumber(const char* p, const char* end);
+        const char* readString(const char* p, const char* end);
+        int endNumber(void);
+        int endString(void);
+
+    public:
+        // Constructor; 
+        Reader(Lept::Handler& handler);
+        // Destructor; 
+        ~Reader(void);
+
+        // get-Functions; 
+        int getStatus(void) const;
+        size_t getOffset(void) const; /* input bytes consumed, up to the error if any */
+        int getDepth(void) const;
+
+        // set-Functions; 
+        void reset(void);
+
+        /* PARSE_OK while the input so far is a valid prefix, the first error otherwise */
+        int feed(const char* data, size_t len);
+        /* end of input, PARSE_OK if exactly one value was read */
+        int finish(void);
+    };
+
+    /* Lept::Handler writing the events back as JSON in another format, 
+     * output matches Value::stringify() except that numbers are copied as written 
+     * and the maximum line width is ignored, it takes a look ahead the events do not give */
+    class Reformatter : public Lept::Handler
+    {
+    private:
+        Lept::Writer* m_writer;
+        bool m_first; /* next value is the first of its container */
+        bool m_afterKey; /* next value belongs to a key already written */
+
+        bool beginValue(void);
+
+    public:
+        Reformatter(Lept::Writer& w);
+        ~Reformatter(void);
+
+        bool onNull(void);
+        bool onBoolean(bool bln);
+        bool onNumber(double num, const char* txt, size_t len);
+        bool onString(const std::string& str);
+        bool onStartArray(void);
+        bool onEndArray(void);
+        bool onStartObject(void);
+        bool onKey(const std::string& key);
+        bool onEndObject(void);
+    };
+
+    /* Lept::Handler building a Value tree from the events */
+    class Builder : public Lept::Handler
+    {
+    private:
+        Lept::Value* m_root;
+        std::vector<Lept::Value*> m_stack; /* open containers */
+        std::string m_key; /* key of the next member */
+
+        Lept::Value& place(void); /* where the next value goes */
+
+    public:
+        Builder(Lept::Value& root);
+        ~Builder(void);
+
+        void reset(void); /* set root to null, ready for another document */
+
+        bool onNull(void);
+        bool onBoolean(bool bln);
+        bool onNumber(double num, const char* txt, size_t len);
+        bool onString(const std::string& str);
+        bool onStartArray(void);
+        bool onEndArray(void);
+        bool onStartObject(void);
+        bool onKey(const std::string& key);
+        bool onEndObject(void);
+    };
+
+    /* parser taking the text in chunks as it arrives, 
+     * chunks may end anywhere, including inside a string, a number or a \uxxxx escape */
+    class PushParser
+    {
+    private:
+        Lept::Builder m_builder;
+        Lept::Reader m_reader;
+
+    public:
+        // Constructor; 
+        PushParser(Lept::Value& v);
+        // Destructor; 
+        ~PushParser(void);
+
+        // get-Functions; 
+        int getStatus(void) const;
+        size_t getOffset(void) const; /* bytes consumed, up to the error if any */
+
+        // set-Functions; 
+        void reset(void); /* parse another document into v */
+
+        /* the results of Value::parse() on strict JSON, v is null after an error: 
+         * unlike Value::parse(), trailing commas and lone low surrogates are errors */
+        int feed(const char* data, size_t len);
+        int finish(void);
+    };
+
+    /* whitespace stripper working on the text itself, never building a tree: 
+     * strings, numbers and escapes are copied as written, 
+     * without validation invalid input comes out stripped but otherwise as it went in */
+    class Minifier : private Lept::Handler
+    {
+    private:
+        Lept::Writer* m_writer;
+        bool m_validate;
+        Lept::Reader m_reader; /* fed the same input when validating */
+        bool m_inString;
+        bool m_escaped; /* next byte follows a backslash */
+        size_t m_offset; /* input bytes consumed */
+        std::vector<char> m_out; /* stripped text waiting for the writer */
+
+        bool onNull(void);
+        bool onBoolean(bool bln);
+        bool onNumber(double num, const char* txt, size_t len);
+        bool onString(const std::string& str);
+        bool onStartArray(void);
+        bool onEndArray(void);
+        bool onStartObject(void);
+        bool onKey(const std::string& key);
+        bool onEndObject(void);
+
+    public:
+        // Constructor; 
+        Minifier(Lept::Writer& w, bool validate = true);
+        // Destructor; 
+        ~Minifier(void);
+
+        // get-Functions; 
+        size_t getOffset(void) const; /* bytes consumed, up to the error if validating */
+
+        // set-Functions; 
+        void reset(void); /* minify another document */
+
+        /* PARSE_OK, or the first error when validating, chunks may end anywhere */
+        int feed(const char* data, size_t len);
+        /* end of input, PARSE_MISSING_QUOTATION_MARK for an open string even without validation */
+        int finish(void);
+    };
 }
 
 #endif /* _H_LEPTJSON */
\ No newline at end of file
@@ -0,0 +1,494 @@
+#include "loader.h"
+#include <algorithm> /* std::min(), std::max() */
+#include <cerrno> /* errno, EINTR */
+#include <cstring> /* memset() */
+#include <cstdint> /* uintptr_t */
+#include <fcntl.h> /* open(), O_RDONLY */
+#include <sys/stat.h> /* fstat() */
+#ifdef _WIN32
+#include <io.h> /* _open(), _read(), _close() */
+#else
+#include <unistd.h> /* read(), close() */
+#endif
+#ifdef LEPT_IO_URING
+#include <linux/io_uring.h> /* struct io_uring_params, struct io_uring_sqe, struct io_uring_cqe */
+#include <sys/mman.h> /* mmap(), munmap() */
+#include <sys/syscall.h> /* __NR_io_uring_setup, __NR_io_uring_enter */
+#endif
+
+/* macros */
+#if 1
+#ifdef _WIN32
+#define LOADER_OPEN(path) ::_open((path), _O_RDONLY | _O_BINARY)
+#define LOADER_READ(fd, data, len) ::_read((fd), (data), (unsigned int)(len))
+#define LOADER_CLOSE(fd) ::_close(fd)
+#else
+#define LOADER_OPEN(path) ::open((path), O_RDONLY | O_CLOEXEC)
+#define LOADER_READ(fd, data, len) ::read((fd), (data), (len))
+#define LOADER_CLOSE(fd) ::close(fd)
+#endif
+
+/* bytes read at once when the size is unknown */
+#define LOADER_READ_CHUNK 65536
+#endif
+
+
+/* -------- io_uring -------- */
+#ifdef LEPT_IO_URING
+/* submission and completion rings shared with the kernel,
+ * only the I/O thread of the Loader touches them */
+struct LoaderRing
+{
+    int fd;
+    unsigned int entries;
+    unsigned int* sqHead;
+    unsigned int* sqTail;
+    unsigned int sqMask;
+    unsigned int* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int cqMask;
+    struct io_uring_cqe* cqes;
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing; /* same as sqRing on kernels mapping both at once */
+    size_t cqRingSize;
+    size_t sqesSize;
+    unsigned int toSubmit; /* queued since the last io_uring_enter() */
+};
+
+/* operation of a completion, kept in the low bits of user_data */
+enum
+{
+    RING_OPEN = 0,
+    RING_READ,
+    RING_CLOSE
+};
+
+static void ringClose(LoaderRing* ring)
+{
+    if (ring->sqes != nullptr)
+        munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != nullptr && ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    if (ring->sqRing != nullptr)
+        munmap(ring->sqRing, ring->sqRingSize);
+    close(ring->fd);
+    delete ring;
+
+    return;
+}
+/* nullptr where io_uring is missing, forbidden, or too old for IORING_OP_OPENAT and IORING_OP_READ */
+static LoaderRing* ringOpen(unsigned int entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+        return nullptr;
+
+    LoaderRing* ring = new LoaderRing;
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    /* FAST_POLL came with 5.7, after the 5.6 opcodes used here */
+    if (!(params.features & IORING_FEAT_FAST_POLL))
+    {
+        ringClose(ring);
+        return nullptr;
+    }
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sqRingSize = ring->cqRingSize = std::max(ring->sqRingSize, ring->cqRingSize);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void* sq = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring->sqRing = (sq == MAP_FAILED) ? nullptr : sq;
+    if (ring->sqRing != nullptr && (params.features & IORING_FEAT_SINGLE_MMAP))
+        ring->cqRing = ring->sqRing;
+    else if (ring->sqRing != nullptr)
+    {
+        void* cq = mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        ring->cqRing = (cq == MAP_FAILED) ? nullptr : cq;
+    }
+    void* sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    ring->sqes = (sqes == MAP_FAILED) ? nullptr : (struct io_uring_sqe*)sqes;
+    if (ring->sqRing == nullptr || ring->cqRing == nullptr || ring->sqes == nullptr)
+    {
+        ringClose(ring);
+        return nullptr;
+    }
+
+    char* sqBase = (char*)ring->sqRing;
+    char* cqBase = (char*)ring->cqRing;
+    ring->sqHead = (unsigned int*)(sqBase + params.sq_off.head);
+    ring->sqTail = (unsigned int*)(sqBase + params.sq_off.tail);
+    ring->sqMask = *(unsigned int*)(sqBase + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned int*)(sqBase + params.sq_off.array);
+    ring->cqHead = (unsigned int*)(cqBase + params.cq_off.head);
+    ring->cqTail = (unsigned int*)(cqBase + params.cq_off.tail);
+    ring->cqMask = *(unsigned int*)(cqBase + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cqBase + params.cq_off.cqes);
+
+    return ring;
+}
+/* submit what is queued, then wait for at least wait completions; 
+ * -EAGAIN and -EBUSY pass once completions are reaped, other errors mean the ring is broken */
+static int ringEnter(LoaderRing* ring, unsigned int wait)
+{
+    for (;;)
+    {
+        int ret = (int)syscall(__NR_io_uring_enter, ring->fd, ring->toSubmit, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (ret >= 0)
+        {
+            ring->toSubmit -= std::min<unsigned int>((unsigned int)ret, ring->toSubmit);
+            return 0;
+        }
+        if (errno != EINTR)
+            return -errno;
+    }
+}
+/* queue an operation, submitting the queue first if it is full, nullptr if that does not make room */
+static struct io_uring_sqe* ringSqe(LoaderRing* ring, unsigned char opcode, int fd, uint64_t data)
+{
+    unsigned int tail = *ring->sqTail;
+    if (tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->entries)
+        ringEnter(ring, 0);
+    if (tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->entries)
+        return nullptr;
+
+    unsigned int index = tail & ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = data;
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++ring->toSubmit;
+
+    return sqe;
+}
+static bool ringRead(LoaderRing* ring, LoadBuffer* buffer)
+{
+    size_t len = std::min<size_t>(buffer->expected - buffer->size, 1u << 30);
+    struct io_uring_sqe* sqe = ringSqe(ring, IORING_OP_READ, buffer->fd, (uint64_t)(uintptr_t)buffer | RING_READ);
+    if (sqe == nullptr)
+        return false;
+    sqe->addr = (uint64_t)(uintptr_t)(buffer->data.data() + buffer->size);
+    sqe->len = (unsigned int)len;
+    sqe->off = buffer->size;
+
+    return true;
+}
+#endif
+
+
+/* -------- Loader -------- */
+#if 1
+// Constructor;
+Loader::Loader(const std::vector<std::string>& files, bool ordered, unsigned int workers, bool uring) :
+    m_files(&files),
+    m_ordered(ordered),
+    m_ring(nullptr),
+    m_pool(LOADER_QUEUE_DEPTH + workers),
+    m_free(),
+    m_ready(files.size(), nullptr),
+    m_readyOrder(),
+    m_submitted(0),
+    m_taken(0),
+    m_stop(false)
+{
+    for (LoadBuffer& buffer : this->m_pool)
+        this->m_free.push_back(&buffer);
+#ifdef LEPT_IO_URING
+    /* every file has one operation in flight, plus the close of files already done */
+    if (uring)
+        this->m_ring = ringOpen(2 * LOADER_QUEUE_DEPTH);
+#else
+    (void)uring;
+#endif
+    this->m_thread = std::thread(&Loader::run, this);
+}
+// Destructor;
+Loader::~Loader(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_stop = true;
+    }
+    this->m_freed.notify_all();
+    this->m_thread.join();
+#ifdef LEPT_IO_URING
+    if (this->m_ring != nullptr)
+        ringClose(this->m_ring);
+#endif
+}
+
+/* get-Functions */
+bool Loader::isUring(void) const
+{
+    return (this->m_ring != nullptr);
+}
+
+LoadBuffer* Loader::take(bool wait)
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    if (wait)
+        this->m_freed.wait(lock, [this]() { return this->m_stop || !this->m_free.empty() || this->m_submitted == this->m_files->size(); });
+    if (this->m_stop || this->m_free.empty() || this->m_submitted == this->m_files->size())
+        return nullptr;
+
+    LoadBuffer* buffer = this->m_free.back();
+    this->m_free.pop_back();
+    buffer->index = this->m_submitted++;
+    buffer->size = 0;
+    buffer->expected = 0;
+    buffer->error = 0;
+    buffer->fd = -1;
+
+    return buffer;
+}
+void Loader::complete(LoadBuffer* buffer)
+{
+    if (buffer->data.size() < buffer->size + 1)
+        buffer->data.resize(buffer->size + 1);
+    buffer->data[buffer->size] = '\0';
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_ready[buffer->index] = buffer;
+        if (!this->m_ordered)
+            this->m_readyOrder.push_back(buffer->index);
+    }
+    this->m_loaded.notify_all();
+
+    return;
+}
+
+LoadBuffer* Loader::next(void)
+{
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    if (this->m_taken == this->m_files->size())
+        return nullptr;
+
+    size_t index = this->m_taken++;
+    if (this->m_ordered)
+        this->m_loaded.wait(lock, [this, index]() { return this->m_ready[index] != nullptr; });
+    else
+    {
+        this->m_loaded.wait(lock, [this]() { return !this->m_readyOrder.empty(); });
+        index = this->m_readyOrder.front();
+        this->m_readyOrder.pop_front();
+    }
+    LoadBuffer* buffer = this->m_ready[index];
+    this->m_ready[index] = nullptr;
+
+    return buffer;
+}
+void Loader::release(LoadBuffer* buffer)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_free.push_back(buffer);
+    }
+    this->m_freed.notify_all();
+
+    return;
+}
+
+/* I/O components */
+#if 1
+void Loader::loadBlocking(LoadBuffer* buffer)
+{
+    const std::string& path = (*this->m_files)[buffer->index];
+    bool isStdin = (path == "-");
+    int fd = isStdin ? 0 : LOADER_OPEN(path.c_str());
+    if (fd < 0)
+    {
+        buffer->error = errno;
+        return;
+    }
+
+    /* regular files come in one read() plus the one seeing their end */
+    struct stat st;
+    size_t want = (fstat(fd, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG) ? (size_t)st.st_size + 1 : LOADER_READ_CHUNK;
+    for (;;)
+    {
+        if (buffer->data.size() < buffer->size + want + 1)
+            buffer->data.resize(buffer->size + want + 1);
+        long ret = (long)LOADER_READ(fd, &buffer->data[buffer->size], want);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            buffer->error = errno;
+            break;
+        }
+        if (ret == 0)
+            break;
+        buffer->size += (size_t)ret;
+        want = LOADER_READ_CHUNK;
+    }
+    if (!isStdin)
+        LOADER_CLOSE(fd);
+
+    return;
+}
+void Loader::runBlocking(void)
+{
+    LoadBuffer* buffer;
+    while ((buffer = this->take(true)) != nullptr)
+    {
+        this->loadBlocking(buffer);
+        this->complete(buffer);
+    }
+
+    return;
+}
+void Loader::runUring(void)
+{
+#ifdef LEPT_IO_URING
+    /* each file goes open -> read (repeated on short reads) -> close,
+     * its buffer is handed over as soon as the close is queued */
+    LoaderRing* ring = this->m_ring;
+    unsigned int pending = 0; /* operations in flight */
+    std::vector<LoadBuffer*> inFlight; /* buffers being opened or read */
+    int failure = 0; /* errno of a broken or full ring, the files go on with blocking calls */
+    while (failure == 0)
+    {
+        LoadBuffer* buffer;
+        while ((buffer = this->take(pending == 0)) != nullptr)
+        {
+            const std::string& path = (*this->m_files)[buffer->index];
+            struct io_uring_sqe* sqe = nullptr;
+            if (path != "-")
+                sqe = ringSqe(ring, IORING_OP_OPENAT, AT_FDCWD, (uint64_t)(uintptr_t)buffer | RING_OPEN);
+            if (sqe == nullptr)
+            { /* stdin, or a ring that takes nothing more */
+                failure = (path != "-") ? EBUSY : 0;
+                this->loadBlocking(buffer);
+                this->complete(buffer);
+                if (failure != 0)
+                    break;
+                continue;
+            }
+            sqe->addr = (uint64_t)(uintptr_t)path.c_str();
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            inFlight.push_back(buffer);
+            ++pending;
+        }
+        if (failure != 0 || pending == 0)
+            break;
+
+        int ret = ringEnter(ring, 1);
+        if (ret != 0 && ret != -EAGAIN && ret != -EBUSY)
+        {
+            failure = -ret;
+            break;
+        }
+
+        unsigned int head = *ring->cqHead;
+        unsigned int tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+            int op = (int)(cqe->user_data & 3);
+            buffer = (LoadBuffer*)(uintptr_t)(cqe->user_data & ~(uint64_t)3);
+            int res = cqe->res;
+            --pending;
+
+            if (op == RING_CLOSE)
+                continue;
+            inFlight.erase(std::find(inFlight.begin(), inFlight.end(), buffer));
+            if (op == RING_OPEN)
+            {
+                struct stat st;
+                if (res == -EINVAL)
+                { /* the kernel does not know IORING_OP_OPENAT after all */
+                    this->loadBlocking(buffer);
+                    this->complete(buffer);
+                    continue;
+                }
+                if (res < 0)
+                {
+                    buffer->error = -res;
+                    this->complete(buffer);
+                    continue;
+                }
+                buffer->fd = res;
+                if (fstat(buffer->fd, &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+                { /* pipes and the like, directories fail with EISDIR */
+                    close(buffer->fd);
+                    buffer->fd = -1;
+                    this->loadBlocking(buffer);
+                    this->complete(buffer);
+                    continue;
+                }
+                buffer->expected = (size_t)st.st_size;
+                if (buffer->data.size() < buffer->expected + 1)
+                    buffer->data.resize(buffer->expected + 1);
+            }
+            else if (res < 0 && res != -EINTR && res != -EAGAIN)
+                buffer->error = -res;
+            else if (res == 0)
+                buffer->expected = buffer->size; /* the file shrank */
+            else if (res > 0)
+                buffer->size += (size_t)res;
+
+            if (buffer->error == 0 && buffer->size < buffer->expected)
+            {
+                inFlight.push_back(buffer);
+                if (!ringRead(ring, buffer))
+                {
+                    failure = EBUSY;
+                    ++head;
+                    break;
+                }
+                ++pending;
+                continue;
+            }
+            if (ringSqe(ring, IORING_OP_CLOSE, buffer->fd, RING_CLOSE) != nullptr)
+                ++pending;
+            else
+                close(buffer->fd);
+            buffer->fd = -1;
+            this->complete(buffer);
+        }
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    if (failure != 0)
+    { /* files in flight start over with blocking calls in fresh memory, the kernel may still write into 
+       * their old one, the rest follow */
+        for (LoadBuffer* buffer : inFlight)
+        {
+            if (buffer->fd >= 0)
+                close(buffer->fd);
+            buffer->fd = -1;
+            this->m_abandoned.push_back(std::vector<char>());
+            this->m_abandoned.back().swap(buffer->data);
+            buffer->size = buffer->expected = 0;
+            buffer->error = 0;
+            this->loadBlocking(buffer);
+            this->complete(buffer);
+        }
+        this->runBlocking();
+    }
+#endif
+
+    return;
+}
+void Loader::run(void)
+{
+    if (this->m_ring != nullptr)
+        this->runUring();
+    else
+        this->runBlocking();
+
+    return;
+}
+#endif
+#endif
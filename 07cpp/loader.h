@@ -0,0 +1,79 @@
+#ifndef _H_LOADER
+#define _H_LOADER /* guard */
+
+#include <string> /* std::string */
+#include <vector> /* std::vector */
+#include <deque> /* std::deque */
+#include <thread> /* std::thread */
+#include <mutex> /* std::mutex */
+#include <condition_variable> /* std::condition_variable */
+
+/* files being read at once */
+#ifndef LOADER_QUEUE_DEPTH
+#define LOADER_QUEUE_DEPTH 64
+#endif
+
+/* whole contents of one file, NUL-terminated */
+typedef struct
+{
+    size_t index; /* in the file list */
+    std::vector<char> data; /* kept from one file to the next */
+    size_t size; /* bytes read so far */
+    size_t expected; /* size of the file when opened */
+    int error; /* errno of the failed step, 0 on success */
+    int fd; /* while being read */
+} LoadBuffer;
+
+struct LoaderRing; /* io_uring state, see loader.cpp */
+
+/* reads a list of files ahead of the workers that parse them,
+ * on an I/O thread keeping up to LOADER_QUEUE_DEPTH files in flight:
+ * through io_uring when built with LEPT_IO_URING and the kernel allows it,
+ * with blocking open()/read()/close() otherwise */
+class Loader
+{
+private:
+    const std::vector<std::string>* m_files; /* "-" is stdin */
+    bool m_ordered; /* hand buffers out in list order */
+    LoaderRing* m_ring; /* nullptr for blocking reads */
+    std::vector<LoadBuffer> m_pool;
+    std::vector<LoadBuffer*> m_free;
+    std::vector<LoadBuffer*> m_ready; /* per file, loaded and not yet taken */
+    std::deque<size_t> m_readyOrder; /* files in m_ready in completion order */
+    size_t m_submitted; /* files handed to the I/O thread */
+    size_t m_taken; /* files handed to workers */
+    std::mutex m_mutex;
+    std::condition_variable m_freed; /* a buffer went back to the pool */
+    std::condition_variable m_loaded; /* a file is ready */
+    std::thread m_thread;
+
+    bool m_stop; /* the destructor runs, submit nothing more */
+    /* read targets of files the ring gave up on mid-read, freed only after the ring is closed */
+    std::vector<std::vector<char>> m_abandoned;
+
+    /* a free buffer for the next file, nullptr once all files are submitted, 
+     * or if none is free and wait is false */
+    LoadBuffer* take(bool wait);
+    void complete(LoadBuffer* buffer);
+    void loadBlocking(LoadBuffer* buffer);
+    void runBlocking(void);
+    void runUring(void);
+    void run(void);
+
+public:
+    // Constructor;
+    /* starts reading files, which must outlive the Loader,
+     * ordered makes next() follow the list instead of completion order */
+    Loader(const std::vector<std::string>& files, bool ordered, unsigned int workers, bool uring = true);
+    // Destructor;
+    ~Loader(void);
+
+    // get-Functions;
+    bool isUring(void) const;
+
+    /* next loaded file, nullptr once all were taken; give it back with release() */
+    LoadBuffer* next(void);
+    void release(LoadBuffer* buffer);
+};
+
+#endif
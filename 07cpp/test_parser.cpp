@@ -2,7 +2,11 @@
 #include <cstdlib>
 #include <cstring>
 #include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cmath> /* INFINITY, NAN */
 #include "leptjson.h"
+#include "generator.h"
 
 // main function return value; 
 // 0 for NO-ERROR; 1 for ERROR-OCCURRED; 
@@ -344,6 +348,351 @@ static void testMissingCommaOrBrace(void)
 }
 #endif
 
+static void testDocumentStream(void)
+{
+    Lept::Value v; 
+    const char* lines = "{\"a\":1}\n[true, \"x\"]\r\n  null\n\n\"str\" -1.5e3 {}\n"; 
+    const Lept::Type types[] = { Lept::Type::OBJECT, Lept::Type::ARRAY, Lept::Type::NULLJSON, Lept::Type::STRING, Lept::Type::NUMBER, Lept::Type::OBJECT }; 
+    const size_t begins[] = { 0, 8, 23, 29, 35, 42 }; 
+    const size_t ends[] = { 7, 19, 27, 34, 41, 44 }; 
+
+    Lept::DocumentStream ds(lines); 
+    int count = 0; 
+    while (ds.next(v))
+    {
+        EXPECT_EQ_INT(types[count], v.getType()); 
+        EXPECT_EQ_INT((int)begins[count], (int)ds.getBegin()); 
+        EXPECT_EQ_INT((int)ends[count], (int)ds.getEnd()); 
+        ++count; 
+    }
+    EXPECT_EQ_INT(6, count); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, ds.getStatus()); 
+
+    Lept::DocumentStream empty(" \n\t"); 
+    EXPECT_EQ_INT(0, (int)empty.next(v)); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, empty.getStatus()); 
+
+    /* a broken line stops the stream until resync() */
+    Lept::DocumentStream broken("1\n{\"a\" 2}\n3\n[\"no end\n"); 
+    EXPECT_EQ_INT(1, (int)broken.next(v)); 
+    EXPECT_EQ_INT(0, (int)broken.next(v)); 
+    EXPECT_EQ_INT(Lept::PARSE_MISSING_COLON, broken.getStatus()); 
+    EXPECT_EQ_INT(Lept::Type::NULLJSON, v.getType()); 
+    EXPECT_EQ_INT(0, (int)broken.next(v)); 
+    EXPECT_EQ_INT(1, (int)broken.resync()); 
+    EXPECT_EQ_INT(1, (int)broken.next(v)); 
+    EXPECT_EQ_DOUBLE(3.0, v.getNum()); 
+    EXPECT_EQ_INT(0, (int)broken.next(v)); 
+    EXPECT_EQ_INT(Lept::PARSE_INVALID_STRING_CHAR, broken.getStatus()); 
+    EXPECT_EQ_INT(1, (int)broken.resync()); 
+    EXPECT_EQ_INT(0, (int)broken.next(v)); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, broken.getStatus()); 
+
+    /* values need whitespace between them, as Value::parse() has it */
+    const char* glued[] = { "truefalse\n1\n", "1-2\n1\n", "{}1\n1\n", "\"a\"\"b\"\n1\n" }; 
+    for (const char* context : glued)
+    {
+        EXPECT_EQ_INT(Lept::PARSE_ROOT_NOT_SINGULAR, v.parse(std::string(context, strchr(context, '\n')))); 
+        Lept::DocumentStream stream(context); 
+        EXPECT_EQ_INT(0, (int)stream.next(v)); 
+        EXPECT_EQ_INT(Lept::PARSE_ROOT_NOT_SINGULAR, stream.getStatus()); 
+        EXPECT_EQ_INT(Lept::Type::NULLJSON, v.getType()); 
+        EXPECT_EQ_INT(1, (int)stream.resync()); 
+        EXPECT_EQ_INT(1, (int)stream.next(v)); 
+        EXPECT_EQ_DOUBLE(1.0, v.getNum()); 
+    }
+
+    return; 
+}
+
+/* feed context to a Reader in pieces of size bytes, return the status of finish() */
+static int readInPieces(Lept::Reader& reader, const std::string& context, size_t size)
+{
+    reader.reset(); 
+    for (size_t index = 0; index < context.size(); index += size)
+        reader.feed(context.data() + index, std::min(size, context.size() - index)); 
+
+    return reader.finish(); 
+}
+
+static void testReader(void)
+{
+    std::string JSONCache = {}; 
+    Lept::Format fmt; 
+    Lept::StringWriter w(JSONCache, fmt); 
+    Lept::Reformatter handler(w); 
+    Lept::Reader reader(handler); 
+    const struct { int errinfo; const char* context; } cases[] = {
+        { Lept::PARSE_OK, "null" }, { Lept::PARSE_OK, " [1, \"a\\u00e9\\uD834\\uDD1E\", {\"k\":[]}] " }, 
+        { Lept::PARSE_EXPECT_VALUE, "" }, { Lept::PARSE_EXPECT_VALUE, " " }, { Lept::PARSE_EXPECT_VALUE, "[" }, 
+        { Lept::PARSE_INVALID_VALUE, "nul" }, { Lept::PARSE_INVALID_VALUE, "nulx" }, { Lept::PARSE_INVALID_VALUE, "?" }, 
+        { Lept::PARSE_INVALID_VALUE, "+1" }, { Lept::PARSE_INVALID_VALUE, ".123" }, { Lept::PARSE_INVALID_VALUE, "1." }, 
+        { Lept::PARSE_INVALID_VALUE, "1e" }, { Lept::PARSE_INVALID_VALUE, "-" }, { Lept::PARSE_INVALID_VALUE, "nan" }, 
+        { Lept::PARSE_INVALID_VALUE, "[1,]" }, 
+        { Lept::PARSE_ROOT_NOT_SINGULAR, "null x" }, { Lept::PARSE_ROOT_NOT_SINGULAR, "0123" }, 
+        { Lept::PARSE_ROOT_NOT_SINGULAR, "0x0" }, { Lept::PARSE_ROOT_NOT_SINGULAR, "\"12\\n3\"\"extra\"" }, 
+        { Lept::PARSE_NUMBER_OVERFLOW, "1e309" }, { Lept::PARSE_NUMBER_OVERFLOW, "[-1e309]" }, 
+        { Lept::PARSE_MISSING_QUOTATION_MARK, "\"" }, { Lept::PARSE_MISSING_QUOTATION_MARK, "\"abc" }, 
+        { Lept::PARSE_INVALID_STRING_ESCAPE, "\"\\v\"" }, { Lept::PARSE_INVALID_STRING_ESCAPE, "\"\\" }, 
+        { Lept::PARSE_INVALID_STRING_CHAR, "\"\x01\"" }, 
+        { Lept::PARSE_INVALID_UNICODE_HEX, "\"\\u01\"" }, { Lept::PARSE_INVALID_UNICODE_HEX, "\"\\u0G00\"" }, 
+        { Lept::PARSE_INVALID_UNICODE_HEX, "\"\\u01" }, 
+        { Lept::PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\"" }, { Lept::PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\\\\"" }, 
+        { Lept::PARSE_INVALID_UNICODE_SURROGATE, "\"\\uD800\\uE000\"" }, { Lept::PARSE_INVALID_UNICODE_SURROGATE, "\"\\uDC00\"" }, 
+        { Lept::PARSE_MISSING_COMMA_OR_BRACKET, "[1" }, { Lept::PARSE_MISSING_COMMA_OR_BRACKET, "[1}" }, 
+        { Lept::PARSE_MISSING_COMMA_OR_BRACKET, "[1 2]" }, { Lept::PARSE_MISSING_COMMA_OR_BRACKET, "[[]" }, 
+        { Lept::PARSE_MISSING_KEY, "{" }, { Lept::PARSE_MISSING_KEY, "{1:\"level\"}" }, { Lept::PARSE_MISSING_KEY, "{\"a\":1,}" }, 
+        { Lept::PARSE_MISSING_COLON, "{\"level\"1}" }, { Lept::PARSE_MISSING_COLON, "{\"level\"" }, 
+        { Lept::PARSE_MISSING_COMMA_OR_BRACE, "{\"level\" :1" }, { Lept::PARSE_MISSING_COMMA_OR_BRACE, "{ \"level\":1]" }, 
+        { Lept::PARSE_MISSING_COMMA_OR_BRACE, "{\"\":{} " }
+    }; 
+
+    for (const auto& c : cases)
+    {
+        EXPECT_EQ_INT(c.errinfo, readInPieces(reader, c.context, 4096)); 
+        EXPECT_EQ_INT(c.errinfo, readInPieces(reader, c.context, 1)); 
+        EXPECT_EQ_INT(0, (int)(reader.getOffset() > strlen(c.context))); 
+    }
+
+    /* offset of the offending char */
+    readInPieces(reader, "[1, 2 3]", 2); 
+    EXPECT_EQ_INT(6, (int)reader.getOffset()); 
+
+    return; 
+}
+
+static void testPushParser(void)
+{
+    Lept::Value vDirect, vPushed; 
+    std::string expect = {}, actual = {}; 
+    const char* contexts[] = {
+        "null", "true", " false ", "-0.0", "1.5e-300", "123456789", "\"\"", "\"Hello\\nWorld \\u00A2\\u20AC\\uD834\\uDD1E\"", 
+        "[]", "{}", "[null, [1, [2, []]], {\"a\":{}}]", 
+        "{\"n\":null, \"f\":false, \"t\":true, \"i\":123, \"s\":\"abc\", \"a\":[1, 2, 3], \"o\":{\"1\":1, \"2\":2}}"
+    }; 
+    const size_t sizes[] = { 1, 2, 3, 4096 }; 
+    Lept::PushParser parser(vPushed); 
+
+    for (const char* context : contexts)
+    {
+        EXPECT_EQ_INT(Lept::PARSE_OK, vDirect.parse(context)); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, vDirect.stringify(expect)); 
+        for (size_t size : sizes)
+        {
+            parser.reset(); 
+            size_t len = strlen(context); 
+            for (size_t index = 0; index < len; index += size)
+                EXPECT_EQ_INT(Lept::PARSE_OK, parser.feed(context + index, std::min(size, len - index))); 
+            EXPECT_EQ_INT(Lept::PARSE_OK, parser.finish()); 
+            EXPECT_EQ_INT(vDirect.getType(), vPushed.getType()); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, vPushed.stringify(actual)); 
+            EXPECT_EQ_STDSTRING(expect, actual); 
+        }
+    }
+
+    /* errors leave v null and stick until reset() */
+    parser.reset(); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, parser.feed("[1, {\"a\":", 9)); 
+    EXPECT_EQ_INT(Lept::PARSE_MISSING_COMMA_OR_BRACE, parser.feed("[2] 3", 5)); 
+    EXPECT_EQ_INT(Lept::Type::NULLJSON, vPushed.getType()); 
+    EXPECT_EQ_INT(Lept::PARSE_MISSING_COMMA_OR_BRACE, parser.finish()); 
+    EXPECT_EQ_INT(13, (int)parser.getOffset()); 
+    parser.reset(); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, parser.feed("[\"\\uD8", 6)); 
+    EXPECT_EQ_INT(Lept::PARSE_INVALID_UNICODE_HEX, parser.finish()); 
+    EXPECT_EQ_INT(Lept::Type::NULLJSON, vPushed.getType()); 
+    parser.reset(); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, parser.feed("[\"\\uD834\\u", 10)); 
+    EXPECT_EQ_INT(Lept::PARSE_INVALID_UNICODE_SURROGATE, parser.finish()); 
+
+    /* stricter than Value::parse() */
+    const char* lenient[] = { "[1,]", "{\"a\":1,}", "\"\\uDC00\"" }; 
+    const int errors[] = { Lept::PARSE_INVALID_VALUE, Lept::PARSE_MISSING_KEY, Lept::PARSE_INVALID_UNICODE_SURROGATE }; 
+    for (size_t index = 0; index < 3; ++index)
+    {
+        EXPECT_EQ_INT(Lept::PARSE_OK, vDirect.parse(lenient[index])); 
+        parser.reset(); 
+        parser.feed(lenient[index], strlen(lenient[index])); 
+        EXPECT_EQ_INT(errors[index], parser.finish()); 
+        EXPECT_EQ_INT(Lept::Type::NULLJSON, vPushed.getType()); 
+    }
+
+    return; 
+}
+
+static unsigned int depthOf(const Lept::Value& v)
+{
+    unsigned int depth = 0; 
+    if (v.getType() == Lept::Type::ARRAY)
+    {
+        for (const Lept::Value* elem : *v.getArr())
+            depth = std::max(depth, depthOf(*elem)); 
+        return depth + 1; 
+    }
+    if (v.getType() == Lept::Type::OBJECT)
+    {
+        for (const Lept::Member* member : *v.getObj())
+            depth = std::max(depth, depthOf(*member->value)); 
+        return depth + 1; 
+    }
+
+    return 0; 
+}
+
+static void testGenerated(void)
+{
+    GenShape shape, deep, escaped, numbers, sized; 
+    defaultShape(shape); 
+
+    /* same seed and shape, same bytes */
+    std::string first = {}, second = {}, other = {}; 
+    Generator(shape, 42).generate(first); 
+    Generator(shape, 42).generate(second); 
+    Generator(shape, 43).generate(other); 
+    EXPECT_EQ_INT(1, first == second); 
+    EXPECT_EQ_INT(0, first == other); 
+
+    deep = shape; 
+    deep.maxDepth = 64; 
+    deep.minWidth = deep.maxWidth = deep.minLength = deep.maxLength = 1; 
+    deep.containers = 0.97; 
+    escaped = shape; 
+    escaped.maxString = 200; 
+    escaped.escapes = escaped.unicode = escaped.utf8 = 0.3; 
+    numbers = shape; 
+    numbers.strings = numbers.literals = 0; 
+    numbers.maxLength = 64; 
+    sized = shape; 
+    sized.size = 256 << 10; 
+
+    /* generated text parses, stays within the depth, and round-trips through the tree and the PushParser */
+    const GenShape* shapes[] = { &shape, &deep, &escaped, &numbers, &sized }; 
+    Lept::Format compact('\t', 1, Lept::Newline::NONE); 
+    Lept::Value v, w; 
+    Lept::PushParser parser(w); 
+    for (const GenShape* generated : shapes)
+    {
+        for (uint64_t seed = 1; seed <= 8; ++seed)
+        {
+            std::string text = {}, expect = {}, actual = {}; 
+            Generator(*generated, seed).generate(text); 
+            if (generated->size != 0)
+                EXPECT_EQ_INT(1, text.size() >= generated->size && text.size() < generated->size + 4096); 
+
+            EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(text.c_str())); 
+            EXPECT_EQ_INT(1, depthOf(v) <= std::max(generated->maxDepth, 1u)); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, compact)); 
+            EXPECT_EQ_INT(Lept::PARSE_OK, w.parse(expect.c_str())); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.stringify(actual, compact)); 
+            EXPECT_EQ_INT(1, expect == actual); 
+
+            parser.reset(); 
+            for (size_t index = 0; index < text.size(); index += 4093)
+                EXPECT_EQ_INT(Lept::PARSE_OK, parser.feed(text.c_str() + index, std::min((size_t)4093, text.size() - index))); 
+            EXPECT_EQ_INT(Lept::PARSE_OK, parser.finish()); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.stringify(actual, compact)); 
+            EXPECT_EQ_INT(1, expect == actual); 
+        }
+    }
+
+    return; 
+}
+
+static void testAllocStats(void)
+{
+#ifdef LEPT_ALLOC_STATS
+    std::string out = {}; 
+    Lept::AllocStats parse, destroy; 
+    Lept::resetAllocStats(); 
+    size_t live = Lept::getLiveBytes(); 
+    {
+        Lept::Value v; 
+        EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("{\"a\":[1, \"two\", {\"three\":[]}], \"b\":\"\\u00e9t\\u00e9\"}")); 
+        parse = Lept::getAllocStats(Lept::AllocPhase::PARSE); 
+        EXPECT_EQ_INT(1, parse.allocs > 0 && parse.peak >= live + parse.bytes - parse.freedBytes); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(out)); 
+        EXPECT_EQ_INT(1, Lept::getAllocStats(Lept::AllocPhase::STRINGIFY).allocs > 0); 
+        EXPECT_EQ_INT(0, (int)Lept::getAllocStats(Lept::AllocPhase::DESTROY).frees); 
+    }
+    /* the tree goes away whole, and nothing else did */
+    destroy = Lept::getAllocStats(Lept::AllocPhase::DESTROY); 
+    EXPECT_EQ_INT(1, destroy.freedBytes == parse.bytes - parse.freedBytes); 
+    EXPECT_EQ_INT(1, destroy.frees == parse.allocs - parse.frees); 
+    EXPECT_EQ_INT(0, (int)destroy.allocs); 
+
+    /* failed parses leave nothing behind */
+    live = Lept::getLiveBytes(); 
+    {
+        Lept::Value v; 
+        EXPECT_EQ_INT(Lept::PARSE_MISSING_COMMA_OR_BRACE, v.parse("{\"a\":[1, \"x\"], \"b\":\"y\" \"c\"}")); 
+        EXPECT_EQ_INT(Lept::PARSE_INVALID_STRING_ESCAPE, v.parse("[\"x\", {\"y\":\"\\q\"}]")); 
+        EXPECT_EQ_INT(Lept::PARSE_MISSING_COLON, v.parse("{\"a\" 1}")); 
+    }
+    EXPECT_EQ_INT(1, live == Lept::getLiveBytes()); 
+#else
+    /* counted only in LEPT_ALLOC_STATS builds */
+    Lept::resetAllocStats(); 
+    EXPECT_EQ_INT(0, (int)Lept::getAllocStats(Lept::AllocPhase::PARSE).allocs); 
+    EXPECT_EQ_INT(0, (int)Lept::getLiveBytes()); 
+#endif
+
+    /* handing v its own string back keeps it */
+    {
+        Lept::Value v; 
+        EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("\"kept\"")); 
+        v.setStr(v.getStr()); 
+        std::string expect = "kept", actual = *v.getStr(); 
+        EXPECT_EQ_STDSTRING(expect, actual); 
+    }
+
+    return; 
+}
+
+static void testContextStats(void)
+{
+#ifdef LEPT_CONTEXT_STATS
+    Lept::Value v; 
+    Lept::Context c("[ null , 12.5e1,\"a\\n\\u00e9\\uD834\\uDD1E\", {\"k\" : [[true]]} ]"); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(c)); 
+    const Lept::ContextStats& stats = c.getStats(); 
+    EXPECT_EQ_INT(7, (int)stats.wsBytes); 
+    EXPECT_EQ_INT(26, (int)stats.stringBytes); /* the key counts too */
+    EXPECT_EQ_INT(6, (int)stats.numberBytes); 
+    EXPECT_EQ_INT(8, (int)stats.literalBytes); 
+    EXPECT_EQ_INT(4, (int)stats.escapes); 
+    EXPECT_EQ_INT(3, (int)stats.unicodeEscapes); 
+    EXPECT_EQ_INT(4, (int)stats.maxDepth); 
+    EXPECT_EQ_INT(1, stats.stringCycles > 0 && stats.numberCycles > 0 && stats.wsCycles > 0); 
+
+    /* a later parse adds up, a reset starts over */
+    c.setTxt("[[]]"); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(c)); 
+    EXPECT_EQ_INT(4, (int)c.getStats().maxDepth); 
+    c.resetStats(); 
+    c.setTxt("[[]]"); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(c)); 
+    EXPECT_EQ_INT(2, (int)c.getStats().maxDepth); 
+    EXPECT_EQ_INT(0, (int)c.getStats().stringBytes); 
+#endif
+
+    return; 
+}
+
+/* a Lept::Handler refusing every event */
+class RefusingHandler : public Lept::Handler
+{
+public:
+    bool onNull(void) { return false; }
+    bool onBoolean(bool) { return false; }
+    bool onNumber(double, const char*, size_t) { return false; }
+    bool onString(const std::string&) { return false; }
+    bool onStartArray(void) { return false; }
+    bool onEndArray(void) { return false; }
+    bool onStartObject(void) { return false; }
+    bool onKey(const std::string&) { return false; }
+    bool onEndObject(void) { return false; }
+};
+
 static void testStringifier(void)
 {
     Lept::Value v, w; 
@@ -371,6 +720,647 @@ static void testStringifier(void)
     TEST_STRINGIFIER(v, w, JSONCache, mem, "{\"a\":null, \"b\":true, \"c\":1.25, \"d\":[null, 3e04], \"e\":{\"inner\":\"Hello\"}}", printFlag);
     TEST_STRINGIFIER(v, w, JSONCache, mem, "{\"a\":{\"b\":[1,2,[3,[4,5]], {\"c\":[]}]}}", printFlag);
     TEST_STRINGIFIER(v, w, JSONCache, mem, "{\"level\" : 1 , \"name\" : \"Eric\", \"ID\" : 10092, \"ally\" : [\"LOCK\", [1,2]], \"weapon\" : {\"mask\":\"N95\", \"dura\\tbility\" : 0.35}}", printFlag);
+    TEST_STRINGIFIER(v, w, JSONCache, mem, "{\"name\":\"\\ud834\\udd1e \\u00A2\", \"ctrl\":\"\\u0001\\u001F\"}", printFlag);
+
+    return; 
+}
+
+static void testStringifierFormat(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+
+    v.parse("{\"a\":[1, {}], \"b\":[]}"); 
+    const Lept::Value& shared = v; /* stringification leaves the tree untouched */
+
+    Lept::Format compact('\t', 1, Lept::Newline::NONE); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, shared.stringify(JSONCache, compact)); 
+    expect = "{\"a\":[1,{}],\"b\":[]}"; 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    Lept::Format spaces(' ', 2, Lept::Newline::CRLF); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, shared.stringify(JSONCache, spaces)); 
+    expect = "{\r\n  \"a\":[\r\n    1,\r\n    {\r\n    }\r\n  ],\r\n  \"b\":[\r\n  ]\r\n}"; 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    v.parse("\"\\u0001\\ud834\\udd1e\""); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, compact)); 
+    expect = "\"\\u0001\xF0\x9D\x84\x9E\""; 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    /* trees built by hand, containers made by the constructor */
+    Lept::Value built(Lept::Type::OBJECT); 
+    Lept::Member* member = new Lept::Member; 
+    member->key = new std::string("a"); 
+    member->value = new Lept::Value(Lept::Type::ARRAY); 
+    member->value->appendArrElem(*new Lept::Value(Lept::Type::STRING)); 
+    built.appendObjElem(*member); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, built.stringify(JSONCache, compact)); 
+    expect = "{\"a\":[\"\"]}"; 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    /* nesting deeper than the cached indentation */
+    const int depth = LEPT_INDENT_CACHE_LEVEL + 5; 
+    std::string deep(depth, '['); 
+    deep.append(depth, ']'); 
+    Lept::Format space(' ', 3); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(deep)); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, space)); 
+    expect = {}; 
+    for (int level = 0; level < depth; ++level)
+    {
+        expect.append("["); 
+        if (level != depth - 1)
+            expect.append("\n").append((level + 1) * 3, ' '); 
+    }
+    for (int level = depth - 1; level >= 0; --level)
+    {
+        expect.append("\n").append(level * 3, ' '); 
+        expect.append("]"); 
+    }
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    return; 
+}
+
+static void testStringifierSink(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+    Lept::Format fmt; 
+
+    /* several writer buffers worth of output */
+    std::string context = "["; 
+    for (int index = 0; index < 2000; ++index)
+        context.append(index == 0 ? "" : ",").append("{\"key\":\"value \\\"quoted\\\"\", \"n\":1.5}"); 
+    context.append("]"); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, fmt)); 
+
+    std::ostringstream os; 
+    {
+        Lept::StreamWriter w(os, fmt); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(w)); 
+    }
+    JSONCache = os.str(); 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    FILE* fp = tmpfile(); 
+    if (fp != nullptr)
+    {
+        {
+            Lept::StdioWriter w(fp, fmt); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(w)); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.flush()); 
+        }
+        JSONCache.assign(expect.size(), '\0'); 
+        rewind(fp); 
+        EXPECT_EQ_INT((int)expect.size(), (int)fread(&JSONCache[0], 1, expect.size(), fp)); 
+        EXPECT_EQ_STDSTRING(expect, JSONCache); 
+        fclose(fp); 
+    }
+
+    const char* path = "leptjson_test_sink.json"; 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyFile(path, fmt, true)); 
+    std::ifstream ifs(path, std::ios::binary); 
+    std::ostringstream content; 
+    content << ifs.rdbuf(); 
+    ifs.close(); 
+    remove(path); 
+    JSONCache = content.str(); 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    EXPECT_EQ_INT(Lept::STRINGIFY_FILE_OPEN_FAILURE, v.stringifyFile("leptjson_no_such_dir/out.json", fmt)); 
+    {
+        Lept::FdWriter w(-1, fmt); 
+        v.stringify(w); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_FILE_WRITE_FAILURE, w.flush()); 
+    }
+
+    /* in-place replacement, original contents differing at the start, in the middle, by being shorter or longer */
+    const std::string originals[] = { expect, "", "x" + expect, expect.substr(0, 5000) + "x" + expect.substr(5001), expect.substr(0, 9000), expect + "\n" }; 
+    for (const std::string& original : originals)
+    {
+        std::ofstream ofs(path, std::ios::binary); 
+        ofs << original; 
+        ofs.close(); 
+        {
+            Lept::ReplaceWriter w(path, fmt); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(w)); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.commit()); 
+            EXPECT_EQ_INT((int)(original != expect), (int)w.isChanged()); 
+        }
+        std::ifstream ifs(path, std::ios::binary); 
+        std::ostringstream content; 
+        content << ifs.rdbuf(); 
+        JSONCache = content.str(); 
+        EXPECT_EQ_STDSTRING(expect, JSONCache); 
+    }
+    /* a single write of several buffers, compared a buffer at a time, differing in a later one or not at all */
+    std::string large(3 * LEPT_WRITER_BUFFER_SIZE + 7, 'a'); 
+    std::string differing = large; 
+    differing[2 * LEPT_WRITER_BUFFER_SIZE + 3] = 'b'; 
+    const std::string larges[] = { differing, large }; 
+    for (const std::string& original : larges)
+    {
+        std::ofstream ofs(path, std::ios::binary); 
+        ofs << original; 
+        ofs.close(); 
+        {
+            Lept::ReplaceWriter w(path, fmt); 
+            w.write(large.data(), large.size()); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.commit()); 
+            EXPECT_EQ_INT((int)(original != large), (int)w.isChanged()); 
+        }
+        std::ifstream ifs(path, std::ios::binary); 
+        std::ostringstream content; 
+        content << ifs.rdbuf(); 
+        JSONCache = content.str(); 
+        EXPECT_EQ_STDSTRING(large, JSONCache); 
+    }
+    {
+        std::ofstream ofs(path, std::ios::binary); 
+        ofs << expect; 
+    }
+    {
+        /* uncommitted output leaves the file alone */
+        Lept::ReplaceWriter w(path, fmt); 
+        w.write("[]", 2); 
+    }
+    {
+        std::ifstream ifs(path, std::ios::binary); 
+        std::ostringstream content; 
+        content << ifs.rdbuf(); 
+        JSONCache = content.str(); 
+        EXPECT_EQ_STDSTRING(expect, JSONCache); 
+    }
+    remove(path); 
+    {
+        Lept::ReplaceWriter w(path, fmt); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_FILE_OPEN_FAILURE, w.getStatus()); 
+    }
+
+    return; 
+}
+
+static void testStringifierSize(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}; 
+    const char* contexts[] = {
+        "null", "false", "true", "0", "-0", "-10", "1.5", "0.1", "-1e-300", "1e300", "12345678901234567", 
+        "\"\"", "\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u0001 \\u001F \\u00A2\"", 
+        "[]", "{}", "[[[]], {}]", 
+        "{\"a\":null, \"b\":true, \"c\":1.25, \"d\":[null, 3e04], \"e\":{\"in\\tner\":\"Hello\"}}"
+    }; 
+    Lept::Format formats[] = {
+        Lept::Format(), 
+        Lept::Format(' ', 4, Lept::Newline::CRLF), 
+        Lept::Format('\t', 1, Lept::Newline::NONE)
+    }; 
+
+    for (const Lept::Format& fmt : formats)
+    {
+        for (const char* context : contexts)
+        {
+            EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, fmt, true)); 
+            EXPECT_EQ_INT((int)JSONCache.size(), (int)v.stringifySize(fmt)); 
+        }
+    }
+
+    /* nesting deeper than the cached indentation */
+    const int depth = LEPT_INDENT_CACHE_LEVEL * 2; 
+    std::string deep(depth, '['); 
+    deep.append("1").append(depth, ']'); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(deep)); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, formats[1], true)); 
+    EXPECT_EQ_INT((int)JSONCache.size(), (int)v.stringifySize(formats[1])); 
+
+    return; 
+}
+
+static void testStringifierParallel(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+    Lept::Format fmt(' ', 2); 
+
+    std::string array = "[", object = "{"; 
+    for (int index = 0; index < LEPT_PARALLEL_MIN_ELEMENTS * 3 + 7; ++index)
+    {
+        std::string elem = (index % 3 == 0) ? "[1, {\"a\":\"\\n\"}]" : (index % 3 == 1) ? "\"str\"" : std::to_string(index); 
+        array.append(index == 0 ? "" : ",").append(elem); 
+        object.append(index == 0 ? "\"" : ",\"").append(std::to_string(index)).append("\":").append(elem); 
+    }
+    array.append("]"); 
+    object.append("}"); 
+
+    for (const std::string& context : { array, object })
+    {
+        EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, fmt)); 
+
+        JSONCache.clear(); 
+        {
+            Lept::StringWriter w(JSONCache, fmt); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyParallel(w, 4)); 
+        }
+        EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+        FILE* fp = tmpfile(); 
+        if (fp != nullptr)
+        {
+            {
+                Lept::FdWriter w(fileno(fp), fmt); 
+                EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyParallel(w, 3)); 
+                EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.flush()); 
+            }
+            JSONCache.assign(expect.size(), '\0'); 
+            rewind(fp); 
+            EXPECT_EQ_INT((int)expect.size(), (int)fread(&JSONCache[0], 1, expect.size(), fp)); 
+            EXPECT_EQ_STDSTRING(expect, JSONCache); 
+            fclose(fp); 
+        }
+    }
+
+    return; 
+}
+
+static void testStringifierWidth(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("{\"name\":\"x\", \"list\":[1, 2, 3], \"deep\":{\"k\":[true, false, null]}, \"none\":[]}")); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, Lept::Format(' ', 2, Lept::Newline::LF, 30))); 
+    EXPECT_EQ_STRING("{\n  \"name\":\"x\",\n  \"list\":[1,2,3],\n  \"deep\":{\n    \"k\":[true,false,null]\n  },\n  \"none\":[]\n}", JSONCache.c_str()); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, Lept::Format(' ', 2, Lept::Newline::LF, 80))); 
+    EXPECT_EQ_STRING("{\"name\":\"x\",\"list\":[1,2,3],\"deep\":{\"k\":[true,false,null]},\"none\":[]}", JSONCache.c_str()); 
+
+    /* a long array of numbers stays one per line, every line of a wide array of short arrays fits */
+    std::string numbers = "[", pairs = "["; 
+    for (int index = 0; index < LEPT_PARALLEL_MIN_ELEMENTS + 10; ++index)
+    {
+        numbers += (index != 0 ? "," : "") + std::to_string(index); 
+        pairs += (index != 0 ? ",[" : "[") + std::to_string(index) + ",\"" + std::string(index % 30, 'a') + "\",{\"k\":" + std::to_string(-index) + "}]"; 
+    }
+    numbers += "]"; 
+    pairs += "]"; 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(numbers)); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, Lept::Format(' ', 4, Lept::Newline::LF, 100))); 
+    EXPECT_EQ_INT(LEPT_PARALLEL_MIN_ELEMENTS + 12, (int)std::count(JSONCache.begin(), JSONCache.end(), '\n') + 1); 
+
+    const char* contexts[] = { "[]", "[[]]", "[1, [2, [3, [4]]], {\"a\":{\"b\":\"\\u0001\"}}, \"long string that does not fit\"]", pairs.c_str() }; 
+    const unsigned int widths[] = { 0, 1, 12, 20, 40, 80, 100000 }; 
+    for (const char* context : contexts)
+    {
+        EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+        for (unsigned int width : widths)
+        {
+            Lept::Format fmt(' ', 4, Lept::Newline::CRLF, width); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, fmt)); 
+            EXPECT_EQ_INT((int)expect.size(), (int)v.stringifySize(fmt)); 
+
+            /* every element of the wide array is on a line of its own, which it fits */
+            if (width >= 80 && width < 100000 && context == pairs.c_str())
+            {
+                size_t longest = 0, lines = 0; 
+                for (size_t begin = 0, end; begin < expect.size(); begin = end + 2)
+                {
+                    end = std::min(expect.find("\r\n", begin), expect.size()); 
+                    longest = std::max(longest, end - begin); 
+                    ++lines; 
+                }
+                EXPECT_EQ_INT(1, (int)(longest <= width)); 
+                EXPECT_EQ_INT(LEPT_PARALLEL_MIN_ELEMENTS + 12, (int)lines); 
+            }
+
+            JSONCache.clear(); 
+            {
+                Lept::StringWriter w(JSONCache, fmt); 
+                EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyParallel(w, 4)); 
+            }
+            EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+            char buffer[7]; 
+            size_t written = 0; 
+            int ret; 
+            Lept::Cursor cursor(fmt); 
+            JSONCache.clear(); 
+            do
+            {
+                ret = v.stringify(buffer, sizeof(buffer), written, cursor); 
+                JSONCache.append(buffer, written); 
+            } while (ret == Lept::STRINGIFY_NEED_MORE_SPACE); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, ret); 
+            EXPECT_EQ_STDSTRING(expect, JSONCache); 
+        }
+    }
+
+    /* a long key breaks its object like a long string value does */
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("[{\"" + std::string(100, 'k') + "\":1}, {\"k\":1}]")); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(JSONCache, Lept::Format(' ', 2, Lept::Newline::LF, 40))); 
+    expect = "[\n  {\n    \"" + std::string(100, 'k') + "\":1\n  },\n  {\"k\":1}\n]"; 
+    EXPECT_EQ_STDSTRING(expect, JSONCache); 
+
+    /* documents written one after another on a Writer each start at column 0, 
+     * the Writer keeps a reference to its Format */
+    const Lept::Format pretty(' ', 2, Lept::Newline::LF, 40), compact('\t', 1, Lept::Newline::NONE, 40); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("[0,1,2,3,4,5,6,7,8,9]")); 
+    JSONCache.clear(); 
+    {
+        Lept::StringWriter w(JSONCache, pretty); 
+        for (int index = 0; index < 4; ++index)
+        {
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(w)); 
+            w.endLine(); 
+        }
+    }
+    EXPECT_EQ_STRING("[0,1,2,3,4,5,6,7,8,9]\n[0,1,2,3,4,5,6,7,8,9]\n[0,1,2,3,4,5,6,7,8,9]\n[0,1,2,3,4,5,6,7,8,9]\n", JSONCache.c_str()); 
+    JSONCache.clear(); 
+    {
+        Lept::StringWriter w(JSONCache, compact); 
+        for (int index = 0; index < 2; ++index)
+        {
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(w)); 
+            w.endLine(); 
+        }
+    }
+    EXPECT_EQ_STRING("[0,1,2,3,4,5,6,7,8,9]\n[0,1,2,3,4,5,6,7,8,9]\n", JSONCache.c_str()); 
+
+    return; 
+}
+
+static void testStringifierCursor(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+    const char* contexts[] = {
+        "null", "-1.5e-300", "\"\\\" \\u0001 \\ud834\\udd1e long enough to span several buffers\"", "[]", "{}", 
+        "{\"a\":null, \"b\":true, \"c\":1.25, \"d\":[null, 3e04, [], {}], \"e\":{\"in\\tner\":\"Hello\"}}"
+    }; 
+    Lept::Format formats[] = {
+        Lept::Format(), 
+        Lept::Format(' ', 4, Lept::Newline::CRLF), 
+        Lept::Format('\t', 1, Lept::Newline::NONE)
+    }; 
+    const size_t sizes[] = { 1, 2, 3, 7, 64, 4096 }; 
+    char buffer[4096]; 
+
+    for (const Lept::Format& fmt : formats)
+    {
+        for (const char* context : contexts)
+        {
+            EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, fmt)); 
+            for (size_t size : sizes)
+            {
+                Lept::Cursor cursor(fmt); 
+                size_t written = 0; 
+                int ret; 
+                JSONCache.clear(); 
+                while ((ret = v.stringify(buffer, size, written, cursor)) == Lept::STRINGIFY_NEED_MORE_SPACE)
+                    JSONCache.append(buffer, written); 
+                JSONCache.append(buffer, written); 
+                EXPECT_EQ_INT(Lept::STRINGIFY_OK, ret); 
+                EXPECT_EQ_INT(1, (int)cursor.isDone()); 
+                EXPECT_EQ_STDSTRING(expect, JSONCache); 
+            }
+        }
+    }
+
+    std::string deep(LEPT_CURSOR_MAX_DEPTH + 1, '['); 
+    deep.append(LEPT_CURSOR_MAX_DEPTH + 1, ']'); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(deep)); 
+    Lept::Cursor cursor(formats[2]); 
+    size_t written = 0; 
+    EXPECT_EQ_INT(Lept::STRINGIFY_DEPTH_EXCEEDED, v.stringify(buffer, sizeof(buffer), written, cursor)); 
+
+    return; 
+}
+
+static void testStringifierReformatter(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+    const char* contexts[] = {
+        "null", "-1.5", "\"\\\" \\u0001 \\ud834\\udd1e long enough to span several chunks\"", "[]", "{}", " [ [ ] , { } ] ", 
+        "{\"a\":null, \"b\":true, \"c\":1.25, \"d\":[null, 3, [], {}], \"e\":{\"in\\tner\":\"Hello\"}, \"f\":false}"
+    }; 
+    Lept::Format formats[] = {
+        Lept::Format(), 
+        Lept::Format(' ', 4, Lept::Newline::CRLF), 
+        Lept::Format('\t', 1, Lept::Newline::NONE)
+    }; 
+    const size_t sizes[] = { 1, 2, 3, 7, 4096 }; 
+
+    for (const Lept::Format& fmt : formats)
+    {
+        for (const char* context : contexts)
+        {
+            EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+            EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, fmt)); 
+            for (size_t size : sizes)
+            {
+                JSONCache.clear(); 
+                Lept::StringWriter w(JSONCache, fmt); 
+                Lept::Reformatter handler(w); 
+                Lept::Reader reader(handler); 
+                EXPECT_EQ_INT(Lept::PARSE_OK, readInPieces(reader, context, size)); 
+                EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.flush()); 
+                EXPECT_EQ_STDSTRING(expect, JSONCache); 
+                EXPECT_EQ_INT(0, reader.getDepth()); 
+            }
+        }
+    }
+
+    /* numbers are copied as written */
+    JSONCache.clear(); 
+    {
+        Lept::StringWriter w(JSONCache, formats[2]); 
+        Lept::Reformatter handler(w); 
+        Lept::Reader reader(handler); 
+        EXPECT_EQ_INT(Lept::PARSE_OK, readInPieces(reader, "[1E+2, -0.10]", 3)); 
+    }
+    EXPECT_EQ_STRING("[1E+2,-0.10]", JSONCache.c_str()); 
+
+    RefusingHandler refusing; 
+    Lept::Reader reader(refusing); 
+    EXPECT_EQ_INT(Lept::PARSE_HANDLER_ABORTED, readInPieces(reader, "[1, 2]", 4096)); 
+    EXPECT_EQ_INT(Lept::PARSE_HANDLER_ABORTED, readInPieces(reader, "1", 4096)); 
+
+    return; 
+}
+
+static void testStringifierMinifier(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}, expect = {}; 
+    Lept::Format fmt('\t', 1, Lept::Newline::NONE); 
+    /* strings full of quotes, backslashes and blanks, so that 64-byte blocks split escapes and strings */
+    std::string pretty = "{\n\t\"a b\" : [ 1, -2.5 , true,\tfalse, null ],\r\n"; 
+    for (int index = 0; index < 40; ++index)
+    {
+        pretty += "\t\"k" + std::to_string(index) + "\" : [ \"" + std::string(2 * (index % 7), '\\'); 
+        pretty += " \\\" x  \\\\\\\" \\\\\" ,\n\t" + std::string(index, ' ') + "[ { } , [ \"\\\\\" ] ] ],\n"; 
+    }
+    pretty += "\t\"end\" : \"  \"\n}\n"; 
+    const char* contexts[] = { "null", " 0 ", "\"\\\\\"", "[ ]", "{ \"\\\"\" : \" \\\\ \" }", pretty.c_str() }; 
+    const size_t sizes[] = { 1, 3, 63, 64, 65, 4096 }; 
+
+    for (const char* context : contexts)
+    {
+        EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(context)); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringify(expect, fmt)); 
+        for (size_t size : sizes)
+        {
+            for (int validate = 0; validate < 2; ++validate)
+            {
+                JSONCache.clear(); 
+                Lept::StringWriter w(JSONCache, fmt); 
+                Lept::Minifier minifier(w, validate != 0); 
+                size_t len = strlen(context); 
+                for (size_t offset = 0; offset < len; offset += size)
+                    EXPECT_EQ_INT(Lept::PARSE_OK, minifier.feed(context + offset, std::min(size, len - offset))); 
+                EXPECT_EQ_INT(Lept::PARSE_OK, minifier.finish()); 
+                EXPECT_EQ_INT(Lept::STRINGIFY_OK, w.flush()); 
+                EXPECT_EQ_STDSTRING(expect, JSONCache); 
+            }
+        }
+    }
+
+    /* numbers and escapes are copied as written */
+    JSONCache.clear(); 
+    {
+        Lept::StringWriter w(JSONCache, fmt); 
+        Lept::Minifier minifier(w); 
+        EXPECT_EQ_INT(Lept::PARSE_OK, minifier.feed("[ 1E+2 , \"\\u00e9\" ]", 19)); 
+        EXPECT_EQ_INT(Lept::PARSE_OK, minifier.finish()); 
+    }
+    EXPECT_EQ_STRING("[1E+2,\"\\u00e9\"]", JSONCache.c_str()); 
+
+    /* errors are found when validating, the open string even without */
+    JSONCache.clear(); 
+    Lept::StringWriter w(JSONCache, fmt); 
+    Lept::Minifier validating(w), stripping(w, false); 
+    EXPECT_EQ_INT(Lept::PARSE_MISSING_COMMA_OR_BRACKET, validating.feed("[1 2]", 5)); 
+    EXPECT_EQ_INT(3, (int)validating.getOffset()); 
+    validating.reset(); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, validating.feed("[1, \"2", 6)); 
+    EXPECT_EQ_INT(Lept::PARSE_MISSING_QUOTATION_MARK, validating.finish()); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, stripping.feed("[1 2]", 5)); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, stripping.finish()); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, stripping.feed(" \"\\\" ", 5)); 
+    EXPECT_EQ_INT(Lept::PARSE_MISSING_QUOTATION_MARK, stripping.finish()); 
+
+    return; 
+}
+
+/* UTF-16 code units of UTF-8 str, to check the canonical member order */
+static std::u16string toUtf16(const std::string& str)
+{
+    std::u16string units; 
+    for (size_t index = 0; index < str.size(); )
+    {
+        unsigned char lead = (unsigned char)str[index]; 
+        int extra = (lead >= 0xF0) ? 3 : (lead >= 0xE0) ? 2 : (lead >= 0xC0) ? 1 : 0; 
+        unsigned long code = lead & (0x7F >> extra); 
+        for (int count = 1; count <= extra; ++count)
+            code = (code << 6) | ((unsigned char)str[index + count] & 0x3F); 
+        index += extra + 1; 
+        if (code >= 0x10000)
+        {
+            units.push_back((char16_t)(0xD800 + ((code - 0x10000) >> 10))); 
+            units.push_back((char16_t)(0xDC00 + ((code - 0x10000) & 0x3FF))); 
+        }
+        else
+            units.push_back((char16_t)code); 
+    }
+
+    return units; 
+}
+
+static void testStringifierCanonical(void)
+{
+    Lept::Value v; 
+    std::string JSONCache = {}; 
+
+    /* numbers, from RFC 8785 appendix B and ECMAScript Number::toString() */
+    const char* numbers[][2] = {
+        { "0", "0" }, { "-0", "0" }, { "1", "1" }, { "-1", "-1" }, { "4.50", "4.5" }, { "0.002", "0.002" }, 
+        { "1e-7", "1e-7" }, { "0.000001", "0.000001" }, { "1e20", "100000000000000000000" }, { "1e21", "1e+21" }, 
+        { "1e30", "1e+30" }, { "333333333.33333329", "333333333.3333333" }, { "-1.5e-10", "-1.5e-10" }, 
+        { "9007199254740992", "9007199254740992" }, { "295147905179352830000", "295147905179352830000" }, 
+        { "5e-324", "5e-324" }, { "1.7976931348623157e308", "1.7976931348623157e+308" }, 
+        { "0.1", "0.1" }, { "123.456", "123.456" }, { "1e-6", "0.000001" }, { "1.5e-7", "1.5e-7" }
+    }; 
+    for (auto& number : numbers)
+    {
+        EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(number[0])); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyCanonical(JSONCache)); 
+        EXPECT_EQ_STRING(number[1], JSONCache.c_str()); 
+    }
+
+    /* only the required escapes, lowercase hex */
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("\"\\u20ac\\/\\\"\\\\\\b\\f\\n\\r\\t\\u001F\\u007f\"")); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyCanonical(JSONCache)); 
+    EXPECT_EQ_STRING("\"\xE2\x82\xAC/\\\"\\\\\\b\\f\\n\\r\\t\\u001f\x7F\"", JSONCache.c_str()); 
+
+    /* RFC 8785 3.2.3 sorting example, whatever the Format */
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("{ \"\\u20ac\": \"Euro Sign\", \"\\r\": \"Carriage Return\", \"\\ufb33\": \"Hebrew Letter Dalet With Dagesh\", "
+        "\"1\": \"One\", \"\\ud83d\\ude00\": \"Emoji: Grinning Face\", \"\\u0080\": \"Control\", \"\\u00f6\": \"Latin Small Letter O With Diaeresis\" }")); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyCanonical(JSONCache)); 
+    EXPECT_EQ_STRING("{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xC2\x80\":\"Control\",\"\xC3\xB6\":\"Latin Small Letter O With Diaeresis\","
+        "\"\xE2\x82\xAC\":\"Euro Sign\",\"\xF0\x9F\x98\x80\":\"Emoji: Grinning Face\",\"\xEF\xAC\xB3\":\"Hebrew Letter Dalet With Dagesh\"}", JSONCache.c_str()); 
+
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse("[ { \"b\" : [ 1, { \"z\": null, \"a\": true } ], \"a\" : { } }, [ ] ]")); 
+    Lept::Format fmt(' ', 4, Lept::Newline::CRLF); 
+    JSONCache.clear(); 
+    {
+        Lept::StringWriter w(JSONCache, fmt); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyCanonical(w)); 
+    }
+    EXPECT_EQ_STRING("[{\"a\":{},\"b\":[1,{\"a\":true,\"z\":null}]},[]]", JSONCache.c_str()); 
+
+    /* wide objects go through the radix sort, keys share prefixes and mix planes */
+    const char* pieces[] = { "", "a", "ab", "\xC3\xB6", "\xE2\x82\xAC", "\xEF\xAC\xB3", "\xF0\x9F\x98\x80", "\x7F", "\xED\x9F\xBF" }; 
+    const size_t count = sizeof(pieces) / sizeof(pieces[0]); 
+    std::vector<std::string> keys; 
+    for (size_t i = 0; i < count; ++i)
+        for (size_t j = 0; j < count; ++j)
+            for (size_t k = 0; k < count; k += 2)
+                keys.push_back(std::string(pieces[(i * 7) % count]) + pieces[j] + pieces[k]); 
+    std::sort(keys.begin(), keys.end()); 
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end()); 
+    std::string json = "{"; 
+    for (size_t index = keys.size(); index-- > 0; )
+        json += "\"" + keys[index] + "\":" + std::to_string(index) + ((index != 0) ? "," : "}"); 
+    EXPECT_EQ_INT(Lept::PARSE_OK, v.parse(json)); 
+    EXPECT_EQ_INT(Lept::STRINGIFY_OK, v.stringifyCanonical(JSONCache)); 
+
+    std::sort(keys.begin(), keys.end(), [](const std::string& a, const std::string& b) { return toUtf16(a) < toUtf16(b); }); 
+    Lept::Value sorted; 
+    EXPECT_EQ_INT(Lept::PARSE_OK, sorted.parse(JSONCache)); 
+    EXPECT_EQ_INT((int)keys.size(), (int)sorted.getObj()->size()); 
+    bool inOrder = (keys.size() == sorted.getObj()->size()); 
+    for (size_t index = 0; inOrder && index < keys.size(); ++index)
+        inOrder = (keys[index] == *sorted.getObjElem(index)->key); 
+    EXPECT_EQ_INT(1, inOrder); 
+
+    /* no text for numbers set to infinity or NaN, at the root or nested */
+    const double nonFinite[] = { INFINITY, -INFINITY, NAN }; 
+    for (double num : nonFinite)
+    {
+        Lept::Value number(Lept::Type::NUMBER), array(Lept::Type::ARRAY); 
+        number.setNum(num); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_NOT_FINITE, number.stringifyCanonical(JSONCache)); 
+        EXPECT_EQ_INT(1, JSONCache.empty()); 
+        Lept::Value* elem = new Lept::Value(Lept::Type::NUMBER); 
+        elem->setNum(num); 
+        array.appendArrElem(*elem); 
+        EXPECT_EQ_INT(Lept::STRINGIFY_NOT_FINITE, array.stringifyCanonical(JSONCache)); 
+    }
 
     return; 
 }
@@ -393,11 +1383,26 @@ int main(void)
     testMissingKey(); 
     testMissingColon(); 
     testMissingCommaOrBrace();
+    testReader();
+    testDocumentStream();
+    testPushParser();
+    testGenerated();
+    testAllocStats();
+    testContextStats();
 
     printf("JSON parser: %d out of %d (%3.2f%%) tests passed. \n", test_pass, test_count, test_pass * 100.0 / test_count);
 
     RESET_TEST; 
     testStringifier();
+    testStringifierFormat();
+    testStringifierSink();
+    testStringifierSize();
+    testStringifierParallel();
+    testStringifierCursor();
+    testStringifierWidth();
+    testStringifierReformatter();
+    testStringifierMinifier();
+    testStringifierCanonical();
     printf("JSON stringifier: %d out of %d (%3.2f%%) tests passed. \n", test_pass, test_count, test_pass * 100.0 / test_count);
 
     return main_ret;
@@ -0,0 +1,31 @@
+/* built once per generation, with Lept renamed so that all generations link into one program:
+ * HISTORY_GENERATION names the Generation defined here, HISTORY_NAME and HISTORY_LEVEL describe it */
+#include "leptjson.h"
+#include "history.h"
+
+static void* create(void)
+{
+    return new Lept::Value;
+}
+static void destroy(void* v)
+{
+    delete (Lept::Value*)v;
+
+    return;
+}
+static int parse(void* v, const char* json)
+{
+    return ((Lept::Value*)v)->parse(json);
+}
+#if HISTORY_LEVEL >= HISTORY_STRINGIFY
+static int stringify(const void* v, std::string& out)
+{
+    static const Lept::Format compact('\t', 1, Lept::Newline::NONE);
+
+    return ((const Lept::Value*)v)->stringify(out, compact);
+}
+#else
+#define stringify nullptr
+#endif
+
+extern const Generation HISTORY_GENERATION = { HISTORY_NAME, HISTORY_LEVEL, create, destroy, parse, stringify };
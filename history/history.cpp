@@ -0,0 +1,284 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono> /* std::chrono::steady_clock */
+#include <string>
+#include <vector>
+#include <algorithm> /* std::sort(), std::max() */
+#include <new> /* std::bad_alloc */
+#include <cstddef> /* std::max_align_t */
+#include "history.h"
+#include "generator.h"
+
+/* scalar documents per corpus of single values */
+#define HISTORY_SCALARS 20000
+/* bytes of the generated mixed document */
+#define HISTORY_GENERATED_SIZE (4 << 20)
+/* the size of each block sits in front of it */
+#define HISTORY_HEADER_SIZE alignof(std::max_align_t)
+
+extern const Generation generation01, generation02, generation03, generation04, generation05, generationJSON_parser, generation07;
+
+/* allocation counters, fed by the global operator new below */
+static size_t allocCount = 0;
+static size_t liveBytes = 0;
+
+void* operator new(size_t size)
+{
+    char* block = (char*)malloc(size + HISTORY_HEADER_SIZE);
+    if (block == nullptr)
+        throw std::bad_alloc();
+    *(size_t*)block = size;
+    ++allocCount;
+    liveBytes += size;
+
+    return block + HISTORY_HEADER_SIZE;
+}
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+void operator delete(void* p) noexcept
+{
+    if (p == nullptr)
+        return;
+
+    char* block = (char*)p - HISTORY_HEADER_SIZE;
+    liveBytes -= *(size_t*)block;
+    free(block);
+}
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+
+/* -------- corpus -------- */
+#if 1
+/* documents parsed one by one, each generation gets those of its level and below */
+typedef struct
+{
+    const char* name;
+    int level;
+    std::vector<std::string> texts;
+    size_t bytes;
+} Corpus;
+
+static void addCorpus(std::vector<Corpus>& corpora, const char* name, int level, std::vector<std::string>& texts)
+{
+    Corpus corpus{ name, level, std::vector<std::string>(), 0 };
+    corpus.texts.swap(texts);
+    for (const std::string& text : corpus.texts)
+        corpus.bytes += text.size();
+    corpora.push_back(corpus);
+
+    return;
+}
+
+/* HISTORY_SCALARS single values of a shape without containers */
+static std::vector<std::string> makeScalars(GenShape& shape, uint64_t seed)
+{
+    std::vector<std::string> texts(HISTORY_SCALARS);
+    shape.maxDepth = 0;
+    Generator gen(shape, seed);
+    for (std::string& text : texts)
+        gen.generate(text);
+
+    return texts;
+}
+
+static std::vector<Corpus> makeCorpora(void)
+{
+    std::vector<Corpus> corpora;
+    std::vector<std::string> texts;
+    GenShape shape;
+
+    static const char* const literals[] = { "null", "true", "false", " null ", "\ttrue\n", "\r\nfalse " };
+    Random random(1);
+    for (unsigned int index = 0; index < HISTORY_SCALARS; ++index)
+        texts.push_back(random.pick(literals, sizeof(literals) / sizeof(literals[0])));
+    addCorpus(corpora, "literals", HISTORY_LITERALS, texts);
+
+    defaultShape(shape);
+    shape.strings = shape.literals = 0;
+    texts = makeScalars(shape, 2);
+    addCorpus(corpora, "numbers", HISTORY_NUMBERS, texts);
+
+    defaultShape(shape);
+    shape.integers = shape.decimals = shape.exponents = shape.literals = 0;
+    shape.maxString = 64;
+    shape.escapes = 0.05;
+    shape.unicode = 0.0;
+    shape.utf8 = 0.0; /* up to 05cpp, bytes past 0x7F fail the signed check against 0x20 */
+    texts = makeScalars(shape, 3);
+    addCorpus(corpora, "strings", HISTORY_STRINGS, texts);
+    shape.unicode = 0.1;
+    texts = makeScalars(shape, 4);
+    addCorpus(corpora, "unicode", HISTORY_UNICODE, texts);
+
+    texts.assign(1, makeTwitter());
+    addCorpus(corpora, "twitter", HISTORY_CONTAINERS, texts);
+    texts.assign(1, makeCanada());
+    addCorpus(corpora, "canada", HISTORY_CONTAINERS, texts);
+    texts.assign(1, makeCitm());
+    addCorpus(corpora, "citm", HISTORY_CONTAINERS, texts);
+    defaultShape(shape);
+    shape.utf8 = 0.0;
+    shape.size = HISTORY_GENERATED_SIZE;
+    texts.assign(1, std::string());
+    Generator(shape, 5).generate(texts[0]);
+    addCorpus(corpora, "generated", HISTORY_CONTAINERS, texts);
+
+    return corpora;
+}
+#endif
+
+
+/* -------- measurement -------- */
+#if 1
+typedef struct
+{
+    double parse; /* median seconds per run */
+    double stringify; /* 0 if not supported */
+    size_t allocs; /* made by parse() */
+    size_t treeBytes; /* live after parse(), Values included */
+    size_t leaked; /* still live after the Values were destroyed */
+    size_t rejected; /* documents parse() refused */
+} Result;
+
+static double elapsed(std::chrono::steady_clock::time_point t0, std::chrono::steady_clock::time_point t1)
+{
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+static Result measure(const Generation& gen, const Corpus& corpus, unsigned int warmup, unsigned int iterations)
+{
+    Result r = { 0.0, 0.0, 0, 0, 0, 0 };
+    std::vector<double> parseTimes, stringifyTimes;
+    std::vector<void*> values(corpus.texts.size());
+
+    for (unsigned int run = 0; run < warmup + iterations; ++run)
+    {
+        size_t live = liveBytes;
+        for (void*& v : values)
+            v = gen.create();
+
+        size_t count = allocCount;
+        auto t0 = std::chrono::steady_clock::now();
+        size_t rejected = 0;
+        for (size_t index = 0; index < values.size(); ++index)
+            rejected += (gen.parse(values[index], corpus.texts[index].c_str()) != 0);
+        auto t1 = std::chrono::steady_clock::now();
+        r.allocs = allocCount - count;
+        r.treeBytes = liveBytes - live;
+        r.rejected = rejected;
+
+        auto t2 = t1, t3 = t1;
+        if (gen.stringify != nullptr && rejected == 0)
+        {
+            std::string out;
+            out.reserve(corpus.bytes + corpus.bytes / 2);
+            t2 = std::chrono::steady_clock::now();
+            for (void* v : values)
+                gen.stringify(v, out);
+            t3 = std::chrono::steady_clock::now();
+        }
+
+        for (void* v : values)
+            gen.destroy(v);
+        r.leaked = liveBytes - live;
+        if (run >= warmup)
+        {
+            parseTimes.push_back(elapsed(t0, t1));
+            if (t3 != t2)
+                stringifyTimes.push_back(elapsed(t2, t3));
+        }
+    }
+
+    std::sort(parseTimes.begin(), parseTimes.end());
+    r.parse = parseTimes[parseTimes.size() / 2];
+    if (!stringifyTimes.empty())
+    {
+        std::sort(stringifyTimes.begin(), stringifyTimes.end());
+        r.stringify = stringifyTimes[stringifyTimes.size() / 2];
+    }
+    return r;
+}
+#endif
+
+static void usage(FILE* fp)
+{
+    fprintf(fp,
+        "usage: leptjson_history [options] [generation...]\n"
+        "  generation          01cpp ... 07cpp or JSON_parser, all of them when omitted\n"
+        "  -n, --iterations N  measured runs per document (default: 5)\n"
+        "  -w, --warmup N      unmeasured runs before them (default: 1)\n"
+        "  -h, --help          show this help\n");
+
+    return;
+}
+
+int main(int argc, char* argv[])
+{
+    const Generation* generations[] = { &generation01, &generation02, &generation03, &generation04, &generation05, &generationJSON_parser, &generation07 };
+    unsigned int iterations = 5, warmup = 1;
+    std::vector<const Generation*> chosen;
+    for (int index = 1; index < argc; ++index)
+    {
+        const char* arg = argv[index];
+        bool hasNext = (index + 1 < argc);
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        {
+            usage(stdout);
+            return 0;
+        }
+        else if ((!strcmp(arg, "-n") || !strcmp(arg, "--iterations")) && hasNext)
+            iterations = std::max(1, atoi(argv[++index]));
+        else if ((!strcmp(arg, "-w") || !strcmp(arg, "--warmup")) && hasNext)
+            warmup = (unsigned int)std::max(0, atoi(argv[++index]));
+        else
+        {
+            const Generation* found = nullptr;
+            for (const Generation* gen : generations)
+                found = !strcmp(gen->name, arg) ? gen : found;
+            if (found == nullptr)
+            {
+                usage(stderr);
+                return 2;
+            }
+            chosen.push_back(found);
+        }
+    }
+    if (chosen.empty())
+        chosen.assign(generations, generations + sizeof(generations) / sizeof(generations[0]));
+
+#ifndef NDEBUG
+    fprintf(stderr, "leptjson_history: assertions are on, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n");
+#endif
+    std::vector<Corpus> corpora = makeCorpora();
+    printf("%u warmup and %u measured runs per document, MB/s of input text, memory per input byte\n", warmup, iterations);
+    printf("%-12s %-10s %10s %10s %10s %10s %12s\n", "generation", "document", "parse MB/s", "stfy MB/s", "allocs", "memory", "leaked");
+    for (const Generation* gen : chosen)
+    {
+        for (const Corpus& corpus : corpora)
+        {
+            if (corpus.level > gen->level)
+                continue;
+            Result r = measure(*gen, corpus, warmup, iterations);
+            if (r.rejected != 0)
+            {
+                printf("%-12s %-10s rejected %zu of %zu documents\n", gen->name, corpus.name, r.rejected, corpus.texts.size());
+                continue;
+            }
+
+            char stringify[16] = "-";
+            if (r.stringify != 0.0)
+                snprintf(stringify, sizeof(stringify), "%.1f", corpus.bytes / 1e6 / r.stringify);
+            printf("%-12s %-10s %10.1f %10s %10zu %9.2fx %12zu\n", gen->name, corpus.name,
+                corpus.bytes / 1e6 / r.parse, stringify, r.allocs, (double)r.treeBytes / corpus.bytes, r.leaked);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+#ifndef _H_HISTORY
+#define _H_HISTORY /* guard */
+
+#include <string> /* std::string */
+
+/* what a generation parses, each level includes the ones before */
+#define HISTORY_LITERALS 1 /* null, true, false (01cpp) */
+#define HISTORY_NUMBERS 2 /* (02cpp) */
+#define HISTORY_STRINGS 3 /* without \u escapes (03cpp) */
+#define HISTORY_UNICODE 4 /* \u escapes and surrogate pairs (04cpp) */
+#define HISTORY_CONTAINERS 5 /* arrays and objects (05cpp, JSON_parser) */
+#define HISTORY_STRINGIFY 6 /* (07cpp) */
+
+/* one generation of the library, compiled by adapter.cpp under its own namespace */
+typedef struct
+{
+    const char* name; /* directory of the generation */
+    int level; /* HISTORY_LITERALS to HISTORY_STRINGIFY */
+    void* (*create)(void); /* a null Lept::Value */
+    void (*destroy)(void* v);
+    int (*parse)(void* v, const char* json); /* PARSE_OK is 0 in every generation */
+    int (*stringify)(const void* v, std::string& out); /* compact, nullptr below HISTORY_STRINGIFY */
+} Generation;
+
+#endif